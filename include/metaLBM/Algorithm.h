@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <utility>
 
+#include "Analysis.h"
 #include "Boundary.h"
 #include "Collision.h"
 #include "Commons.h"
@@ -48,7 +49,10 @@ namespace lbm {
     T* squaredQContractedPi1Ptr;
     T* cubedQContractedPi1Ptr;
     T* fNonEq8Ptr;
-    T* distributionPtr;
+    T* scalarSumPtr;
+    unsigned int* probeIndexPtr;
+    unsigned int numberLocalProbes;
+    T* probeValuePtr;
 
   protected:
     T* haloDistributionPreviousPtr;
@@ -56,8 +60,6 @@ namespace lbm {
 
     Computation<architecture, L::dimD> computationLocal;
 
-    Packer<T> packer;
-    Unpacker<T> unpacker;
     Collision_<architecture> collision;
 
     std::chrono::duration<double> dtComputation;
@@ -65,25 +67,30 @@ namespace lbm {
 
   public:
     bool isStored;
+    bool isAnalyzed;
+    bool isProbed;
 
     Algorithm(FieldList<T, architecture>& fieldList_in,
               Distribution<T, architecture>& distribution_in)
-      : densityPtr(fieldList_in.density.getData(FFTWInit::numberElements))
+      : densityPtr(fieldList_in.density.getData(lSD::pVolume()))
       , velocityPtr(fieldList_in.velocity.getData(FFTWInit::numberElements))
       , forcePtr(fieldList_in.force.getData(FFTWInit::numberElements))
-      , alphaPtr(fieldList_in.alpha.getData(FFTWInit::numberElements))
-      , T2Ptr(fieldList_in.T2.getData(FFTWInit::numberElements))
-      , T3Ptr(fieldList_in.T3.getData(FFTWInit::numberElements))
-      , T4Ptr(fieldList_in.T4.getData(FFTWInit::numberElements))
-      , T2_approxPtr(fieldList_in.T2_approx.getData(FFTWInit::numberElements))
-      , T3_approxPtr(fieldList_in.T3_approx.getData(FFTWInit::numberElements))
-      , T4_approxPtr(fieldList_in.T4_approx.getData(FFTWInit::numberElements))
-      , pi1DiagonalPtr(fieldList_in.pi1Diagonal.getData(FFTWInit::numberElements))
-      , pi1SymmetricPtr(fieldList_in.pi1Symmetric.getData(FFTWInit::numberElements))
-      , squaredQContractedPi1Ptr(fieldList_in.squaredQContractedPi1.getData(FFTWInit::numberElements))
-      , cubedQContractedPi1Ptr(fieldList_in.cubedQContractedPi1.getData(FFTWInit::numberElements))
-      , fNonEq8Ptr(fieldList_in.fNonEq8.getData(FFTWInit::numberElements))
-      , distributionPtr(distribution_in.getData(FFTWInit::numberElements))
+      , alphaPtr(fieldList_in.alpha.getData(lSD::pVolume()))
+      , T2Ptr(fieldList_in.T2.getData(lSD::pVolume()))
+      , T3Ptr(fieldList_in.T3.getData(lSD::pVolume()))
+      , T4Ptr(fieldList_in.T4.getData(lSD::pVolume()))
+      , T2_approxPtr(fieldList_in.T2_approx.getData(lSD::pVolume()))
+      , T3_approxPtr(fieldList_in.T3_approx.getData(lSD::pVolume()))
+      , T4_approxPtr(fieldList_in.T4_approx.getData(lSD::pVolume()))
+      , pi1DiagonalPtr(fieldList_in.pi1Diagonal.getData(lSD::pVolume()))
+      , pi1SymmetricPtr(fieldList_in.pi1Symmetric.getData(lSD::pVolume()))
+      , squaredQContractedPi1Ptr(fieldList_in.squaredQContractedPi1.getData(lSD::pVolume()))
+      , cubedQContractedPi1Ptr(fieldList_in.cubedQContractedPi1.getData(lSD::pVolume()))
+      , fNonEq8Ptr(fieldList_in.fNonEq8.getData(lSD::pVolume()))
+      , scalarSumPtr(NULL)
+      , probeIndexPtr(NULL)
+      , numberLocalProbes(0)
+      , probeValuePtr(NULL)
       , haloDistributionPreviousPtr(distribution_in.getHaloDataPrevious())
       , haloDistributionNextPtr(distribution_in.getHaloDataNext())
       , computationLocal(L::halo(), lSD::sEnd() + L::halo(), {d::X, d::Y, d::Z})
@@ -92,6 +99,8 @@ namespace lbm {
       , dtComputation()
       , dtCommunication()
       , isStored(false)
+      , isAnalyzed(false)
+      , isProbed(false)
     {}
 
     LBM_DEVICE
@@ -123,40 +132,62 @@ namespace lbm {
       if (isStored) {
         storeFields(iP, numberElements);
       }
+
+      if (isProbed) {
+        storeProbe(iP);
+      }
     }
 
     double getCommunicationTime() { return dtCommunication.count(); }
 
+    /// Holds the latest populations once an iteration has completed
+    LBM_HOST
+    T* getHaloDistributionNextPtr() { return haloDistributionNextPtr; }
+
     double getComputationTime() { return dtComputation.count(); }
 
-    LBM_HOST
-    void pack(const Stream<architecture>& stream) {
-      LBM_INSTRUMENT_OFF("Algorithm<T, AlgorithmType::Pull>::pack", 4)
+  protected:
+    /// Same moments as storeFields, for the probe owning iP if any.
+    /// Probe indices are sorted, so a binary search over the few owned
+    /// probes replaces a per-cell lookup
+    LBM_DEVICE LBM_HOST
+    void storeProbe(const Position& iP) {
+      const unsigned int indexLocal = hSD::getIndexLocal(iP);
+      unsigned int iProbe = 0;
+      unsigned int iLast = numberLocalProbes;
+      while (iProbe < iLast) {
+        const unsigned int iMiddle = (iProbe + iLast) / 2;
+        if (probeIndexPtr[iMiddle] < indexLocal) iProbe = iMiddle + 1;
+        else iLast = iMiddle;
+      }
+      if (iProbe == numberLocalProbes || probeIndexPtr[iProbe] != indexLocal) return;
 
-        computationLocal.Do(stream, packer, distributionPtr,
-                            haloDistributionNextPtr, FFTWInit::numberElements);
-      computationLocal.synchronize();
-    }
+      T* valuePtr = probeValuePtr + iProbe * (1 + L::dimD);
+      const MathVector<T, L::dimD> velocity = collision.getHydrodynamicVelocity();
 
-    LBM_HOST
-    void unpack(const Stream<architecture>& stream) {
-      LBM_INSTRUMENT_OFF("Algorithm<T, AlgorithmType::Pull>::unpack", 4)
-        computationLocal.Do(stream, unpacker, haloDistributionNextPtr,
-                            distributionPtr, FFTWInit::numberElements);
-      computationLocal.synchronize();
+      valuePtr[0] = collision.getDensity();
+      for(auto iD = 0; iD < L::dimD; ++iD) {
+        valuePtr[1 + iD] = velocity[iD];
+      }
     }
 
-  protected:
+    /// numberElements strides the transformed velocity and force only
     LBM_DEVICE LBM_HOST
     void storeFields(const Position& iP, const unsigned int numberElements) {
       LBM_INSTRUMENT_OFF("Algorithm<T, AlgorithmType::Pull>::storeFields", 4)
 
         const auto indexLocal = hSD::getIndexLocal(iP);
 
+      const MathVector<T, L::dimD> velocity = collision.getHydrodynamicVelocity();
+
       densityPtr[indexLocal] = collision.getDensity();
       for(auto iD = 0; iD < L::dimD; ++iD) {
-        (velocityPtr + iD * numberElements)[indexLocal] =
-          collision.getHydrodynamicVelocity()[iD];
+        (velocityPtr + iD * numberElements)[indexLocal] = velocity[iD];
+      }
+
+      if(isAnalyzed) {
+        ScalarPartialSums<T>::accumulate(scalarSumPtr, collision.getDensity(),
+                                         velocity);
       }
 
       if(writeAlpha) {
@@ -173,11 +204,11 @@ namespace lbm {
         T4_approxPtr[indexLocal] = collision.getT4_approx();
 
         for(auto iD = 0; iD < L::dimD; ++iD) {
-          (pi1DiagonalPtr + iD * numberElements)[indexLocal] =
+          (pi1DiagonalPtr + iD * lSD::pVolume())[indexLocal] =
             collision.getPi1Diagonal()[iD];
         }
         for(auto iD = 0; iD < 2 * L::dimD - 3; ++iD) {
-          (pi1SymmetricPtr + iD * numberElements)[indexLocal] =
+          (pi1SymmetricPtr + iD * lSD::pVolume())[indexLocal] =
             collision.getPi1Symmetric()[iD];
         }
 
@@ -239,8 +270,7 @@ namespace lbm {
                         {d::X, d::Y, d::Z})
     {}
 
-    using Base::pack;
-    using Base::unpack;
+    using Base::getHaloDistributionNextPtr;
 
   };
 
@@ -292,8 +322,7 @@ namespace lbm {
         {d::X, d::Y, d::Z})
     {}
 
-    using Base::pack;
-    using Base::unpack;
+    using Base::getHaloDistributionNextPtr;
   };
 
 
@@ -357,8 +386,7 @@ namespace lbm {
       Base::dtComputation = (t0 - t1);
     }
 
-    using Base::pack;
-    using Base::unpack;
+    using Base::getHaloDistributionNextPtr;
 
   };
 
@@ -446,8 +474,7 @@ namespace lbm {
 
     }
 
-    using Base::pack;
-    using Base::unpack;
+    using Base::getHaloDistributionNextPtr;
 
   };
 
@@ -513,8 +540,7 @@ namespace lbm {
       Base::dtComputation = (t0 - t1);
     }
 
-    using Base::pack;
-    using Base::unpack;
+    using Base::getHaloDistributionNextPtr;
 
   };
 
@@ -602,8 +628,7 @@ namespace lbm {
 
     }
 
-    using Base::pack;
-    using Base::unpack;
+    using Base::getHaloDistributionNextPtr;
   };
 
 
@@ -4,6 +4,7 @@
 
 #ifdef USE_FFTW
 #include <fftw3-mpi.h>
+#include "Transformer.h"
 #endif
 
 #include "Commons.h"
@@ -35,31 +36,13 @@ namespace lbm {
   private:
     using Base = AnalysisScalar<T>;
 
-    T& scalarRef;
-    T* localDensityPtr;
-    T* localVelocityPtr;
-
   public:
     static constexpr auto analysisName = "total_energy";
 
-  TotalEnergy(T* localDensityPtr_in,
-              T* localVelocityPtr_in)
+  TotalEnergy()
     : Base()
-      , scalarRef(Base::scalar)
-      , localDensityPtr(localDensityPtr_in)
-      , localVelocityPtr(localVelocityPtr_in)
     {}
 
-    LBM_HOST
-      void operator()(const Position& iP) {
-      auto index = lSD::getIndex(iP);
-      for (auto iD = 0; iD < L::dimD; ++iD) {
-        scalarRef += 0.5 * localDensityPtr[index] *
-          (localVelocityPtr + iD * FFTWInit::numberElements)[index] *
-          (localVelocityPtr + iD * FFTWInit::numberElements)[index];
-      }
-    }
-
     using Base::normalize;
     using Base::reset;
     using Base::scalar;
@@ -97,6 +80,26 @@ namespace lbm {
     using Base::scalar;
   };
 
+  /**
+   * Scalar sums accumulated by the collision kernel while it stores
+   * fields, so analyzed steps need no extra sweep.
+   */
+  template <class T>
+  struct ScalarPartialSums {
+    enum Index { Energy, Mass, Velocity2Max, Size };
+
+    LBM_DEVICE LBM_HOST LBM_INLINE
+    static void accumulate(T* sumPtr, const T density,
+                           const MathVector<T, L::dimD>& velocity) {
+      const T velocity2 = velocity.norm2();
+
+      sumPtr[Energy] += 0.5 * density * velocity2;
+      sumPtr[Mass] += density;
+      if (velocity2 > sumPtr[Velocity2Max]) {
+        sumPtr[Velocity2Max] = velocity2;
+      }
+    }
+  };
 
   template <class T, unsigned int maxWaveNumber>
     class AnalysisSpectral {
@@ -125,52 +128,46 @@ namespace lbm {
     using Base = AnalysisSpectral<T, MaxWaveNumber>;
 
     T* localArrayPtr;
-    T (&spectraRef)[MaxWaveNumber];
+    T* fourierArrayPtr;
     ForwardFFT<double, Architecture::CPU, PartitionningType::OneD,
       L::dimD, L::dimD> forward;
-    BackwardFFT<double, Architecture::CPU, PartitionningType::OneD,
-      L::dimD, L::dimD> backward;
 
   public:
     const std::string analysisName;
 
+    /// Transforms out of place into fourierArrayPtr, leaving the field untouched
   PowerSpectra(T* localArrayPtr_in,
+               T* fourierArrayPtr_in,
                const ptrdiff_t globalLength_in[3],
                const std::string& analysisName_in)
     : Base()
-      , spectraRef(Base::spectra)
       , localArrayPtr(localArrayPtr_in)
-      , forward(localArrayPtr_in, globalLength_in)
-      , backward(localArrayPtr_in, globalLength_in)
+      , fourierArrayPtr(fourierArrayPtr_in)
+      , forward(localArrayPtr_in, fourierArrayPtr_in, globalLength_in)
       , analysisName(analysisName_in)
     {}
 
+    /// Bins the mode at index into spectraPtr, which may be thread-local
     LBM_HOST
-      void operator()(const Position& iFP, const unsigned int index,
-                      const WaveNumber& iK, const unsigned int kNorm) {
-      T coefficient = (T)1;
-      if (iK[L::dimD - 1] == 0) {
-        coefficient = (T)0.5;
-      }
+      void operator()(T* spectraPtr, const unsigned int index,
+                      const unsigned int kNorm, const T weight) const {
+      if (kNorm >= MaxWaveNumber) return;
 
       T energy = (T)0;
       for (auto iD = 0; iD < L::dimD; ++iD) {
-        fftw_complex* fourierArrayPtr =
-          ((fftw_complex*)(localArrayPtr + iD * FFTWInit::numberElements));
+        fftw_complex* fourierComponentPtr =
+          ((fftw_complex*)(fourierArrayPtr + iD * FFTWInit::numberElements));
         energy +=
-          fourierArrayPtr[index][p::Re] * fourierArrayPtr[index][p::Re];
+          fourierComponentPtr[index][p::Re] * fourierComponentPtr[index][p::Re];
         energy +=
-          fourierArrayPtr[index][p::Im] * fourierArrayPtr[index][p::Im];
+          fourierComponentPtr[index][p::Im] * fourierComponentPtr[index][p::Im];
       }
 
-      if (kNorm < MaxWaveNumber)
-        spectraRef[kNorm] += coefficient * energy;
+      spectraPtr[kNorm] += weight * energy;
     }
 
     void executeForward() { forward.execute(); }
 
-    void executeBackward() { backward.execute(); }
-
     using Base::normalize;
     using Base::reset;
     using Base::spectra;
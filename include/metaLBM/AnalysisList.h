@@ -1,6 +1,7 @@
 #ifndef ANALYSISLIST_H
 #define ANALYSISLIST_H
 
+#include <cmath>
 #include <fstream>
 #include <ostream>
 #include <string>
@@ -9,7 +10,9 @@
 #include "Commons.h"
 #include "Communication.h"
 #include "Computation.h"
+#include "DynamicArray.h"
 #include "FieldList.h"
+#include "FourierIndex.h"
 #include "Helpers.h"
 #include "Options.h"
 #include "Writer.h"
@@ -25,9 +28,18 @@ namespace lbm {
 
 template <class T, Architecture architecture>
 class ScalarAnalysisList {
+ private:
+  using PartialSums = ScalarPartialSums<T>;
+
+  T* localDensityPtr;
+  T* localVelocityPtr;
+  DynamicArray<T, Architecture::CPU> partialSumArray;
+
  public:
   TotalEnergy<T> totalEnergy;
   TotalEnstrophy<T> totalEnstrophy;
+  T totalMass;
+  T maxMach;
   Communication_& communication;
   ScalarAnalysisWriter_ scalarAnalysisWriter;
   Computation<Architecture::CPU, L::dimD> computationLocal;
@@ -36,13 +48,19 @@ class ScalarAnalysisList {
                      Communication_& communication_in,
                      const unsigned int scalarAnalysisStep_in,
                      const unsigned int startIteration_in)
-    : totalEnergy(fieldList_in.density.getData(FFTWInit::numberElements),
-                  fieldList_in.velocity.getData(FFTWInit::numberElements))
+    : localDensityPtr(fieldList_in.density.getData(lSD::pVolume()))
+    , localVelocityPtr(fieldList_in.velocity.getData(FFTWInit::numberElements))
+    , partialSumArray(PartialSums::Size)
+    , totalEnergy()
     , totalEnstrophy(fieldList_in.vorticity.getData(FFTWInit::numberElements))
+    , totalMass((T)0)
+    , maxMach((T)0)
     , communication(communication_in)
     , scalarAnalysisWriter(prefix, "observables", startIteration_in, scalarAnalysisStep_in)
     , computationLocal(lSD::sStart(), lSD::sEnd())
   {
+    resetPartialSums();
+
     if (MPIInit::rank[d::X] == 0) {
       writeAnalysesHeader();
     }
@@ -52,46 +70,98 @@ class ScalarAnalysisList {
     return scalarAnalysisWriter.getIsAnalyzed(iteration);
   }
 
-  inline void writeAnalyses(const unsigned int iteration) {
-    resetAnalyses();
+  /// Filled by the collision kernel on analyzed steps
+  inline T* getPartialSumPtr() {
+    return partialSumArray.data();
+  }
+
+  /// Sweeps the stored fields when the kernel did not accumulate them
+  inline void accumulatePartialSums() {
+    T* sumPtr = partialSumArray.data();
 
     computationLocal.Do([&] LBM_HOST(const Position& iP) {
-      totalEnergy(iP);
-      totalEnstrophy(iP);
+        const auto index = lSD::getIndex(iP);
+        MathVector<T, L::dimD> velocity;
+        for (auto iD = 0; iD < L::dimD; ++iD) {
+          velocity[iD] = (localVelocityPtr + iD * FFTWInit::numberElements)[index];
+        }
+
+        PartialSums::accumulate(sumPtr, localDensityPtr[index], velocity);
     });
     computationLocal.synchronize();
+  }
+
+  inline void writeAnalyses(const unsigned int iteration) {
+    resetAnalyses();
+    gatherPartialSums();
+
+    if (analyzeTotalEnstrophy) {
+      computationLocal.Do([&] LBM_HOST(const Position& iP) {
+        totalEnstrophy(iP);
+      });
+      computationLocal.synchronize();
+    }
 
     normalizeAnalyses();
     reduceAnalyses();
 
     if (MPIInit::rank[d::X] == 0) {
-      T scalarList[] = {totalEnergy.scalar, totalEnstrophy.scalar};
+      T scalarList[4];
+      unsigned int iS = 0;
+      scalarList[iS++] = totalEnergy.scalar;
+      if (analyzeTotalEnstrophy) scalarList[iS++] = totalEnstrophy.scalar;
+      if (analyzeTotalMass) scalarList[iS++] = totalMass;
+      if (analyzeMaxMach) scalarList[iS++] = sqrt(maxMach / L::cs2);
+
       scalarAnalysisWriter.openFile(iteration);
-      scalarAnalysisWriter.writeAnalysis<2>(iteration, scalarList);
+      scalarAnalysisWriter.writeAnalysis<1 + analyzeTotalEnstrophy + analyzeTotalMass
+                                         + analyzeMaxMach>(iteration, scalarList);
       scalarAnalysisWriter.closeFile();
     }
   }
 
  private:
+  inline void resetPartialSums() {
+    memset(partialSumArray.data(), 0, partialSumArray.size() * sizeof(T));
+  }
+
+  /// Moves the sums into the analyses and clears them
+  inline void gatherPartialSums() {
+    totalEnergy.scalar = partialSumArray[PartialSums::Energy];
+    totalMass = partialSumArray[PartialSums::Mass];
+    maxMach = partialSumArray[PartialSums::Velocity2Max];
+    resetPartialSums();
+  }
+
   inline void resetAnalyses() {
     totalEnergy.reset();
     totalEnstrophy.reset();
+    totalMass = (T)0;
+    maxMach = (T)0;
   }
 
+  /// maxMach holds the squared velocity until it is written
   inline void reduceAnalyses() {
     communication.reduce(&(totalEnergy.scalar), 1);
     communication.reduce(&(totalEnstrophy.scalar), 1);
+    if (analyzeTotalMass) communication.reduce(&totalMass, 1);
+    if (analyzeMaxMach) communication.reduceMax(&maxMach, 1);
   }
 
   inline void normalizeAnalyses() {
     totalEnergy.normalize();
     totalEnstrophy.normalize();
+    totalMass /= gSD::sVolume();
   }
 
   inline void writeAnalysesHeader() {
     std::string header = "iteration";
     header += " " + std::string(totalEnergy.analysisName);
-    header += " " + std::string(totalEnstrophy.analysisName);
+    if (analyzeTotalEnstrophy) {
+      header += " " + std::string(totalEnstrophy.analysisName);
+    }
+    if (analyzeTotalMass) header += " total_mass";
+    if (analyzeMaxMach) header += " max_mach";
     scalarAnalysisWriter.writeHeader(header);
   }
 };
@@ -99,29 +169,27 @@ class ScalarAnalysisList {
 template <class T, Architecture architecture>
 class SpectralAnalysisList {
  private:
-  WaveNumber iK;
-  unsigned int kNorm;
+  DynamicArray<T, Architecture::CPU> fourierArray;
+  FourierIndex& fourierIndex;
 
  public:
   PowerSpectra<T, gFD::maxWaveNumber()> energySpectra;
   PowerSpectra<T, gFD::maxWaveNumber()> forcingSpectra;
   Communication_& communication;
   SpectralAnalysisWriter_ spectralAnalysisWriter;
-  Position offset;
-  Computation<Architecture::CPU, L::dimD> computationFourier;
 
   SpectralAnalysisList(FieldList<T, architecture>& fieldList_in,
                        Communication_& communication_in,
                        const unsigned int spectralAnalysisStep_in,
                        const unsigned int startIteration_in)
-    : energySpectra(fieldList_in.velocity.getData(FFTWInit::numberElements),
-                    globalLengthPtrdiff_t, "energy_spectra")
+    : fourierArray(L::dimD * FFTWInit::numberElements)
+    , fourierIndex(FourierIndex::getInstance())
+    , energySpectra(fieldList_in.velocity.getData(FFTWInit::numberElements),
+                    fourierArray.data(), globalLengthPtrdiff_t, "energy_spectra")
     , forcingSpectra(fieldList_in.force.getData(FFTWInit::numberElements),
-                     globalLengthPtrdiff_t, "forcing_spectra")
+                     fourierArray.data(), globalLengthPtrdiff_t, "forcing_spectra")
     , communication(communication_in)
     , spectralAnalysisWriter(prefix, "spectra", startIteration_in, spectralAnalysisStep_in)
-    , offset(gFD::offset(MPIInit::rank))
-    , computationFourier(lFD::start(), lFD::end())
   {
     if (MPIInit::rank[d::X] == 0) {
       writeAnalysesHeader();
@@ -135,28 +203,8 @@ class SpectralAnalysisList {
   inline void writeAnalyses(const unsigned int iteration) {
     resetAnalyses();
 
-    forwardTransformAnalyses();
-    computationFourier.Do([&] LBM_HOST(const Position& iFP) {
-      auto index = lFD::getIndex(iFP);
-
-      iK[d::X] = iFP[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-                     ? iFP[d::X] + offset[d::X]
-                     : iFP[d::X] + offset[d::X] - gSD::sLength()[d::X];
-      iK[d::Y] = iFP[d::Y] <= gSD::sLength()[d::Y] / 2
-                     ? iFP[d::Y]
-                     : iFP[d::Y] - gSD::sLength()[d::Y];
-      iK[d::Z] = iFP[d::Z] <= gSD::sLength()[d::Z] / 2
-                     ? iFP[d::Z]
-                     : iFP[d::Z] - gSD::sLength()[d::Z];
-      kNorm = iK.norm();
-
-      energySpectra(iFP, index, iK, kNorm);
-      forcingSpectra(iFP, index, iK, kNorm);
-
-    });
-    computationFourier.synchronize();
-
-    backwardTransformAnalyses();
+    transformAndBinAnalysis(energySpectra);
+    transformAndBinAnalysis(forcingSpectra);
 
     normalizeAnalyses();
     reduceAnalyses();
@@ -176,14 +224,30 @@ class SpectralAnalysisList {
     forcingSpectra.reset();
   }
 
-  inline void forwardTransformAnalyses() {
-    energySpectra.executeForward();
-    forcingSpectra.executeForward();
-  }
+  /// Analyses share fourierArray, so each one is binned right after its transform.
+  /// Threads bin into their own spectra, summed once at the end.
+  inline void transformAndBinAnalysis(
+      PowerSpectra<T, gFD::maxWaveNumber()>& powerSpectra) {
+    powerSpectra.executeForward();
+
+    const unsigned int* shellPtr = fourierIndex.getShellPtr();
+    const double* weightPtr = fourierIndex.getWeightPtr();
+    const unsigned int numberModes = fourierIndex.size();
+
+    #pragma omp parallel
+    {
+      T threadSpectra[gFD::maxWaveNumber()] = {0};
 
-  inline void backwardTransformAnalyses() {
-    energySpectra.executeBackward();
-    forcingSpectra.executeBackward();
+      #pragma omp for schedule(static) nowait
+      for (auto index = 0; index < numberModes; ++index) {
+        powerSpectra(threadSpectra, index, shellPtr[index], weightPtr[index]);
+      }
+
+      #pragma omp critical
+      for (auto kNorm = 0; kNorm < gFD::maxWaveNumber(); ++kNorm) {
+        powerSpectra.spectra[kNorm] += threadSpectra[kNorm];
+      }
+    }
   }
 
   inline void reduceAnalyses() {
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <mpi.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Commons.h"
+#include "Computation.h"
+#include "Distribution.h"
+#include "Domain.h"
+#include "Lattice.h"
+#include "Options.h"
+
+namespace lbm {
+
+  /**
+   * Frequent node-local checkpoints complementing the infrequent HDF5 ones.
+   * Each rank packs its unpadded populations, sends them to its partner
+   * rank and writes both its own and its partner's copy under
+   * buddyBackUpPath. A restart after losing one node then reads its
+   * populations back from the partner's disk instead of the filesystem.
+   * Nothing is kept in memory between saves, and nothing is saved while
+   * buddyBackUpPath is empty.
+   *
+   * @tparam T datatype.
+   * @tparam Architecture on which the code is executed.
+   */
+  template <class T, Architecture architecture>
+  class BuddyCheckpoint {
+  private:
+    const int rank;
+    const int partnerRank;
+    const int sourceRank;
+    const unsigned int numberValues;
+    Computation<Architecture::CPU, L::dimD> computationLocal;
+
+  public:
+    BuddyCheckpoint()
+      : rank(MPIInit::rank[d::X])
+      , partnerRank((MPIInit::rank[d::X] + numProcs / 2) % numProcs)
+      , sourceRank((MPIInit::rank[d::X] + numProcs - numProcs / 2) % numProcs)
+      , numberValues(L::dimQ * lSD::sVolume())
+      , computationLocal(lSD::sStart(), lSD::sEnd())
+    {
+      if (buddyBackUpStep && std::string(buddyBackUpPath).size() == 0
+          && rank == 0) {
+        std::cout << "buddyBackUpStep is set but buddyBackUpPath is empty, "
+                  << "buddy checkpoints are disabled" << std::endl;
+      }
+    }
+
+    inline bool getIsBackedUp(const unsigned int iteration) {
+      return buddyBackUpStep && std::string(buddyBackUpPath).size() > 0
+        && (iteration % buddyBackUpStep) == 0;
+    }
+
+    /// Packs the populations and exchanges them with the partner rank
+    void save(const unsigned int iteration,
+              Distribution<T, architecture>& distribution,
+              const T* haloDistributionPtr, const Stream<architecture>& stream) {
+      LBM_INSTRUMENT_ON("BuddyCheckpoint<T>::save", 3)
+
+      std::vector<T> localArray(numberValues);
+      std::vector<T> partnerArray(numberValues);
+      for (auto iQ = 0; iQ < L::dimQ; ++iQ) {
+        T* populationPtr = localArray.data() + iQ * lSD::sVolume();
+
+        if (architecture == Architecture::CPU) {
+          computationLocal.Do([&] LBM_HOST(const Position& iP) {
+              populationPtr[getPackedIndex(iP)] =
+                haloDistributionPtr[hSD::getIndex(iP + L::halo(), iQ)];
+            });
+        }
+        else {
+          const T* stagingPtr =
+            distribution.stagePopulation(stream, haloDistributionPtr, iQ);
+          computationLocal.Do([&] LBM_HOST(const Position& iP) {
+              populationPtr[getPackedIndex(iP)] = stagingPtr[lSD::getIndex(iP)];
+            });
+        }
+        computationLocal.synchronize();
+      }
+
+      MPI_Sendrecv(localArray.data(), numberValues, MPI_DOUBLE, partnerRank, 47,
+                   partnerArray.data(), numberValues, MPI_DOUBLE, sourceRank, 47,
+                   MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+      writeFile(getFileName(rank, "local"), iteration, localArray);
+      writeFile(getFileName(sourceRank, "partner"), iteration, partnerArray);
+    }
+
+    /**
+     * Every rank restores from its own copy or else from its partner's.
+     * Returns false on all ranks when any rank has neither, so that the
+     * caller falls back to the HDF5 checkpoint.
+     */
+    bool restore(const unsigned int iteration,
+                 Distribution<T, architecture>& distribution,
+                 T* haloDistributionPtr, const Stream<architecture>& stream) {
+      LBM_INSTRUMENT_ON("BuddyCheckpoint<T>::restore", 3)
+
+      if (!buddyBackUpStep || std::string(buddyBackUpPath).size() == 0) {
+        return false;
+      }
+
+      std::vector<T> localArray(numberValues);
+      std::vector<T> partnerArray(numberValues);
+      int isLocal = readFile(getFileName(rank, "local"), iteration, localArray);
+      int isPartner = readFile(getFileName(sourceRank, "partner"), iteration,
+                               partnerArray);
+
+      std::vector<int> isLocalArray(numProcs);
+      std::vector<int> isPartnerArray(numProcs);
+      MPI_Allgather(&isLocal, 1, MPI_INT, isLocalArray.data(), 1, MPI_INT,
+                    MPI_COMM_WORLD);
+      MPI_Allgather(&isPartner, 1, MPI_INT, isPartnerArray.data(), 1, MPI_INT,
+                    MPI_COMM_WORLD);
+
+      for (auto iR = 0; iR < numProcs; ++iR) {
+        if (!isLocalArray[iR] && !isPartnerArray[(iR + numProcs / 2) % numProcs]) {
+          return false;
+        }
+      }
+
+      MPI_Request requests[2];
+      int numberRequests = 0;
+      if (!isLocal) {
+        MPI_Irecv(localArray.data(), numberValues, MPI_DOUBLE, partnerRank, 48,
+                  MPI_COMM_WORLD, &requests[numberRequests++]);
+      }
+      if (!isLocalArray[sourceRank]) {
+        MPI_Isend(partnerArray.data(), numberValues, MPI_DOUBLE, sourceRank, 48,
+                  MPI_COMM_WORLD, &requests[numberRequests++]);
+      }
+      MPI_Waitall(numberRequests, requests, MPI_STATUSES_IGNORE);
+
+      for (auto iQ = 0; iQ < L::dimQ; ++iQ) {
+        const T* populationPtr = localArray.data() + iQ * lSD::sVolume();
+
+        if (architecture == Architecture::CPU) {
+          computationLocal.Do([&] LBM_HOST(const Position& iP) {
+              haloDistributionPtr[hSD::getIndex(iP + L::halo(), iQ)] =
+                populationPtr[getPackedIndex(iP)];
+            });
+          computationLocal.synchronize();
+        }
+        else {
+          T* stagingPtr = distribution.getStagingData();
+          computationLocal.Do([&] LBM_HOST(const Position& iP) {
+              stagingPtr[lSD::getIndex(iP)] = populationPtr[getPackedIndex(iP)];
+            });
+          computationLocal.synchronize();
+          distribution.unstagePopulation(stream, haloDistributionPtr, iQ);
+        }
+      }
+
+      if (rank == 0) {
+        std::cout << "Restarting from the buddy checkpoint of iteration "
+                  << iteration << std::endl;
+      }
+      return true;
+    }
+
+  private:
+    static inline unsigned int getPackedIndex(const Position& iP) {
+      return lSD::sLength()[d::Z] * (lSD::sLength()[d::Y] * iP[d::X] + iP[d::Y])
+        + iP[d::Z];
+    }
+
+    /// Copy owned by rankOwner, held locally or for the source rank
+    static inline std::string getFileName(const int rankOwner,
+                                          const std::string& copy) {
+      return std::string(buddyBackUpPath) + "/" + prefix + "_buddy_"
+        + std::to_string(rankOwner) + "_" + copy + ".bin";
+    }
+
+    /// Written to a temporary file renamed once complete
+    inline void writeFile(const std::string& fileName,
+                          const unsigned int iteration,
+                          const std::vector<T>& array) {
+      const std::string temporaryName = fileName + ".tmp";
+      std::ofstream file(temporaryName, std::ios::binary | std::ios::trunc);
+      const unsigned int header[3] = {iteration, numProcs, numberValues};
+
+      file.write(reinterpret_cast<const char*>(header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(array.data()),
+                 numberValues * sizeof(T));
+      file.close();
+
+      if (!file || std::rename(temporaryName.c_str(), fileName.c_str()) != 0) {
+        std::cout << "Could not write buddy checkpoint " << fileName << std::endl;
+      }
+    }
+
+    /// False when missing, incomplete, or from another iteration or run
+    inline bool readFile(const std::string& fileName,
+                         const unsigned int iteration, std::vector<T>& array) {
+      std::ifstream file(fileName, std::ios::binary);
+      unsigned int header[3] = {0, 0, 0};
+
+      file.read(reinterpret_cast<char*>(header), sizeof(header));
+      if (!file || header[0] != iteration || header[1] != numProcs
+          || header[2] != numberValues) {
+        return false;
+      }
+
+      file.read(reinterpret_cast<char*>(array.data()), numberValues * sizeof(T));
+      return (bool)file;
+    }
+  };
+
+}  // namespace lbm
@@ -40,7 +40,7 @@ template <class T, Architecture architecture>
             const unsigned int kMax_in)
     : tau(tau_in)
     , fieldList(fieldList_in)
-    , forcing(gFD::offset(MPIInit::rank), amplitude_in, waveLength_in, kMin_in, kMax_in)
+    , forcing(gSD::sOffset(MPIInit::rank), amplitude_in, waveLength_in, kMin_in, kMax_in)
     , forcingScheme(tau_in)
     , density()
     , velocity{{0}}
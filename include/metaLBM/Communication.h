@@ -88,6 +88,17 @@ namespace lbm {
       MPI_Barrier(MPI_COMM_WORLD);
     }
 
+    LBM_HOST
+    void reduceMax(T* localMaxPtr, unsigned int numberComponents) {
+      if (MPIInit::rank[d::X] == 0) {
+        MPI_Reduce(MPI_IN_PLACE, localMaxPtr, numberComponents, MPI_DOUBLE,
+                   MPI_MAX, 0, MPI_COMM_WORLD);
+      } else {
+        MPI_Reduce(localMaxPtr, localMaxPtr, numberComponents, MPI_DOUBLE,
+                   MPI_MAX, 0, MPI_COMM_WORLD);
+      }
+    }
+
     LBM_HOST
     T reduce(T* localPtr) {
       T localSum = (T)0;
@@ -217,6 +228,7 @@ namespace lbm {
     {}
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
   };
@@ -264,6 +276,7 @@ namespace lbm {
     {}
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -395,6 +408,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
   };
@@ -421,6 +435,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -462,6 +477,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -488,6 +504,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -514,6 +531,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
   };
@@ -532,6 +550,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -560,6 +579,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -579,6 +599,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -600,6 +621,7 @@ namespace lbm {
     using Base::Communication;
 
     using Base::reduce;
+    using Base::reduceMax;
     using Base::sendGlobalToLocal;
     using Base::sendLocalToGlobal;
 
@@ -48,6 +48,18 @@ class Computation<Architecture::CPU, 1>
     }
   }
 
+  /// Same as Do, with the outer loop shared among the OpenMP threads
+  template <typename Callback, typename... Arguments>
+  void DoParallel(Callback function, const Arguments... arguments) {
+    #pragma omp parallel for schedule(static)
+    for (auto i0 = Base::start[Base::dir[0]]; i0 < Base::end[Base::dir[0]];
+         ++i0) {
+      Position iP = start;
+      iP[Base::dir[0]] = i0;
+      function(iP, arguments...);
+    }
+  }
+
   template <typename Callback, typename... Arguments>
   void Do(const Stream<Architecture::CPU>& stream,
           Callback function,
@@ -81,6 +93,22 @@ class Computation<Architecture::CPU, 2>
     }
   }
 
+  /// Same as Do, with the outer loop shared among the OpenMP threads
+  template <typename Callback, typename... Arguments>
+  void DoParallel(Callback function, const Arguments... arguments) {
+    #pragma omp parallel for schedule(static)
+    for (auto i0 = Base::start[Base::dir[0]]; i0 < Base::end[Base::dir[0]];
+         ++i0) {
+      Position iP = start;
+      iP[Base::dir[0]] = i0;
+      for (auto i1 = Base::start[Base::dir[1]]; i1 < Base::end[Base::dir[1]];
+           ++i1) {
+        iP[Base::dir[1]] = i1;
+        function(iP, arguments...);
+      }
+    }
+  }
+
   template <typename Callback, typename... Arguments>
   void Do(const Stream<Architecture::CPU>& stream,
           Callback function,
@@ -118,6 +146,26 @@ class Computation<Architecture::CPU, 3>
     }
   }
 
+  /// Same as Do, with the outer loop shared among the OpenMP threads
+  template <typename Callback, typename... Arguments>
+  void DoParallel(Callback function, const Arguments... arguments) {
+    #pragma omp parallel for schedule(static)
+    for (auto i0 = Base::start[Base::dir[0]]; i0 < Base::end[Base::dir[0]];
+         ++i0) {
+      Position iP = start;
+      iP[Base::dir[0]] = i0;
+      for (auto i1 = Base::start[Base::dir[1]]; i1 < Base::end[Base::dir[1]];
+           ++i1) {
+        iP[Base::dir[1]] = i1;
+        for (auto i2 = Base::start[Base::dir[2]]; i2 < Base::end[Base::dir[2]];
+             ++i2) {
+          iP[Base::dir[2]] = i2;
+          function(iP, arguments...);
+        }
+      }
+    }
+  }
+
   template <typename Callback, typename... Arguments>
   void Do(const Stream<Architecture::CPU>& stream,
           Callback function,
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 
 #include "Commons.h"
+#include "Computation.h"
 #include "Domain.h"
 #include "DynamicArray.cuh"
 #include "Field.h"
@@ -11,25 +13,32 @@
 
 namespace lbm {
 
+/**
+ * Populations, stored only in the two halo arrays swapped at each
+ * iteration. GPU checkpoints go through a host field holding a single
+ * population, reused for every iQ; on CPU the halo arrays are read and
+ * written in place.
+ *
+ * @tparam T datatype.
+ * @tparam Architecture on which the code is executed.
+ */
 template <class T, Architecture architecture>
-class Distribution : public Field<T, L::dimQ, architecture, true> {
+class Distribution {
  private:
-  using Base = Field<T, L::dimQ, architecture, true>;
   DynamicArray<T, architecture> haloArrayPrevious;
   DynamicArray<T, architecture> haloArrayNext;
-
- protected:
-  using Base::array;
+  Field<T, 1, architecture, architecture != Architecture::CPU> stagingField;
+  Computation<architecture, L::dimD> computationLocal;
 
  public:
-  using Base::fieldName;
+  const std::string fieldName;
 
   Distribution()
-      : Base("distribution"),
-        haloArrayPrevious(hSD::volume() * L::dimQ),
-        haloArrayNext(hSD::volume() * L::dimQ) {}
-
-  using Base::getData;
+      : haloArrayPrevious(hSD::volume() * L::dimQ),
+        haloArrayNext(hSD::volume() * L::dimQ),
+        stagingField("distribution"),
+        computationLocal(lSD::sStart(), lSD::sEnd()),
+        fieldName("distribution") {}
 
   LBM_DEVICE LBM_HOST T* getHaloDataPrevious() {
     return haloArrayPrevious.data();
@@ -40,6 +49,37 @@ class Distribution : public Field<T, L::dimQ, architecture, true> {
   DynamicArray<T, architecture>& getHaloArrayPrevious() {
     return haloArrayPrevious;
   }
+
+  /// Host field padded like lSD, NULL on CPU
+  T* getStagingData() {
+    return stagingField.getData(stagingField.getNumberElements());
+  }
+
+  /// Copies population iQ of haloDistributionPtr into the staging field
+  T* stagePopulation(const Stream<architecture>& stream,
+                     const T* haloDistributionPtr, const unsigned int iQ) {
+    T* stagingPtr = getStagingData();
+
+    computationLocal.Do(stream, [=] LBM_HOST LBM_DEVICE(const Position& iP) {
+      stagingPtr[lSD::getIndex(iP)] =
+          haloDistributionPtr[hSD::getIndex(iP + L::halo(), iQ)];
+    });
+    computationLocal.synchronize();
+
+    return stagingPtr;
+  }
+
+  /// Copies the staging field back into population iQ of haloDistributionPtr
+  void unstagePopulation(const Stream<architecture>& stream,
+                         T* haloDistributionPtr, const unsigned int iQ) {
+    const T* stagingPtr = getStagingData();
+
+    computationLocal.Do(stream, [=] LBM_HOST LBM_DEVICE(const Position& iP) {
+      haloDistributionPtr[hSD::getIndex(iP + L::halo(), iQ)] =
+          stagingPtr[lSD::getIndex(iP)];
+    });
+    computationLocal.synchronize();
+  }
 };
 
 }  // namespace lbm
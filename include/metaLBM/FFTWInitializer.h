@@ -2,9 +2,16 @@
 
 #include <fftw3-mpi.h>
 #include <mpi.h>
+#include <string>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "DynamicArray.h"
 #include "Lattice.h"
 #include "MathVector.h"
 #include "Domain.h"
+#include "FourierDomain.h"
 
 namespace lbm {
 
@@ -12,32 +19,137 @@ namespace lbm {
   template <int numThreadsAtCompileTime>
   struct FFTWInitializer {
     static unsigned int numberElements;
+    static unsigned int plannerFlag;
 
     FFTWInitializer() {
       #ifdef USE_FFTW
       fftw_init_threads();
       fftw_mpi_init();
       fftw_plan_with_nthreads(numThreadsAtCompileTime);
+      #ifdef _OPENMP
+      omp_set_num_threads(numThreadsAtCompileTime);
+      #endif
 
       ptrdiff_t lX_fftw;
       ptrdiff_t startX_fftw;
-      numberElements = 2 * fftw_mpi_local_size(L::dimD,
-                Cast<unsigned int, ptrdiff_t, 3>::Do(gSD::sLength()).data(),
-                MPI_COMM_WORLD, &lX_fftw, &startX_fftw);
+      if (isFourierTransposed) {
+        ptrdiff_t lY_fftw;
+        ptrdiff_t startY_fftw;
+        numberElements = 2 * fftw_mpi_local_size_transposed(L::dimD,
+                  Cast<unsigned int, ptrdiff_t, 3>::Do(gSD::sLength()).data(),
+                  MPI_COMM_WORLD, &lX_fftw, &startX_fftw,
+                  &lY_fftw, &startY_fftw);
+      }
+      else {
+        numberElements = 2 * fftw_mpi_local_size(L::dimD,
+                  Cast<unsigned int, ptrdiff_t, 3>::Do(gSD::sLength()).data(),
+                  MPI_COMM_WORLD, &lX_fftw, &startX_fftw);
+      }
+
+      plannerFlag = getPlannerFlag(fftwPlannerT);
+      if (useFFTWWisdom) {
+        importWisdom();
+      }
       #endif
     }
 
     /// Finalizes FFTW
     ~FFTWInitializer() {
       #ifdef USE_FFTW
+      if (useFFTWWisdom) {
+        exportWisdom();
+      }
       fftw_mpi_cleanup();
       #endif
     }
 
+    /// Planners other than FFTW_ESTIMATE overwrite the arrays while planning
+    static inline bool getIsPlanningDestructive() {
+      return plannerFlag != FFTW_ESTIMATE;
+    }
+
+    /// Forward transforms skip the final transpose when Fourier data is transposed
+    static inline unsigned int getForwardFlag() {
+      return isFourierTransposed ? plannerFlag | FFTW_MPI_TRANSPOSED_OUT
+                                 : plannerFlag;
+    }
+
+    /// Backward transforms then expect transposed Fourier data
+    static inline unsigned int getBackwardFlag() {
+      return isFourierTransposed ? plannerFlag | FFTW_MPI_TRANSPOSED_IN
+                                 : plannerFlag;
+    }
+
+    /// Most components transformed together, velocity or vorticity in 3D
+    static constexpr unsigned int maxNumberComponents = 3;
+
+    /// Scratch shared by all transforms of fields with several components,
+    /// as transforms are executed one at a time
+    static inline double* getInterleavedPtr() {
+      static DynamicArray<double, Architecture::CPU>
+        interleavedArray(maxNumberComponents * numberElements);
+      return interleavedArray.data();
+    }
+
+  private:
+    static inline unsigned int getPlannerFlag(const FFTWPlannerType plannerType) {
+      switch (plannerType) {
+      case FFTWPlannerType::Estimate: {
+        return FFTW_ESTIMATE;
+      }
+      case FFTWPlannerType::Measure: {
+        return FFTW_MEASURE;
+      }
+      case FFTWPlannerType::Patient: {
+        return FFTW_PATIENT;
+      }
+      case FFTWPlannerType::Exhaustive: {
+        return FFTW_EXHAUSTIVE;
+      }
+      default: {
+        std::cout << "Wrong type of FFTW planner, using FFTW_ESTIMATE.\n";
+        return FFTW_ESTIMATE;
+      }
+      }
+    }
+
+    /// Wisdom only holds for a given grid, process count and thread count
+    static inline std::string getWisdomFileName() {
+      return "../output/fftw_wisdom_"
+        + std::to_string(gSD::sLength()[d::X]) + "x"
+        + std::to_string(gSD::sLength()[d::Y]) + "x"
+        + std::to_string(gSD::sLength()[d::Z]) + "_"
+        + std::to_string(numProcs) + "_"
+        + std::to_string(numThreadsAtCompileTime) + ".wisdom";
+    }
+
+    /// Reads the wisdom on rank 0 and hands it over to every rank
+    static inline void importWisdom() {
+      if (MPIInit::rank[d::X] == 0) {
+        std::string fileName = getWisdomFileName();
+        if (fftw_import_wisdom_from_filename(fileName.c_str())) {
+          std::cout << "Imported FFTW wisdom from " << fileName << std::endl;
+        }
+      }
+      fftw_mpi_broadcast_wisdom(MPI_COMM_WORLD);
+    }
+
+    /// Collects the wisdom of every rank and writes it on rank 0
+    static inline void exportWisdom() {
+      fftw_mpi_gather_wisdom(MPI_COMM_WORLD);
+      if (MPIInit::rank[d::X] == 0) {
+        std::string fileName = getWisdomFileName();
+        if (!fftw_export_wisdom_to_filename(fileName.c_str())) {
+          std::cout << "Could not export FFTW wisdom to " << fileName << std::endl;
+        }
+      }
+    }
+
   };  // end class FFTWInitializer
 
   using FFTWInit = FFTWInitializer<numThreads>;
 
   template<> unsigned int FFTWInit::numberElements = lSD::pVolume();
+  template<> unsigned int FFTWInit::plannerFlag = FFTW_ESTIMATE;
 
 }  // end namespace lbm
@@ -22,14 +22,17 @@ namespace lbm {
  * @tparam Architecture on which the code is executed.
  * @tparam bool IsWritten whether the current field should be dumped
  * and therefore allocated.
+ * @tparam bool IsTransformed whether the field goes through an in-place
+ * FFT and therefore needs the FFTW padded stride between components.
  */
 
   template <class T, unsigned int NumberComponents, Architecture architecture,
-          bool IsWritten>
+            bool IsWritten, bool IsTransformed = false>
   class FieldAllocator {};
 
-  template <class T, unsigned int NumberComponents>
-  class FieldAllocator<T, NumberComponents, Architecture::Generic, true> {
+  template <class T, unsigned int NumberComponents, bool IsTransformed>
+  class FieldAllocator<T, NumberComponents, Architecture::Generic, true,
+                       IsTransformed> {
   public:
     static constexpr bool IsWritten = true;
 
@@ -38,13 +41,21 @@ namespace lbm {
     FieldAllocator(const std::string& fieldName_in)
       : fieldName(fieldName_in)
   {}
+
+    /// Stride between components: tight unless the field is transformed
+    LBM_HOST
+    static inline unsigned int getNumberElements() {
+      return IsTransformed ? FFTWInit::numberElements : lSD::pVolume();
+    }
 };
 
-  template <class T, unsigned int NumberComponents>
-  class FieldAllocator<T, NumberComponents, Architecture::CPU, true>
-    : public FieldAllocator<T, NumberComponents, Architecture::Generic, true> {
+  template <class T, unsigned int NumberComponents, bool IsTransformed>
+  class FieldAllocator<T, NumberComponents, Architecture::CPU, true, IsTransformed>
+    : public FieldAllocator<T, NumberComponents, Architecture::Generic, true,
+                            IsTransformed> {
   private:
-    using Base = FieldAllocator<T, NumberComponents, Architecture::Generic, true>;
+    using Base = FieldAllocator<T, NumberComponents, Architecture::Generic, true,
+                                IsTransformed>;
 
   protected:
     DynamicArray<T, Architecture::CPU> array;
@@ -52,18 +63,21 @@ namespace lbm {
   public:
     using Base::fieldName;
     using Base::IsWritten;
+    using Base::getNumberElements;
 
     FieldAllocator(const std::string& fieldName_in)
       : Base(fieldName_in)
-      , array(FFTWInit::numberElements * NumberComponents)
+      , array(Base::getNumberElements() * NumberComponents)
     {}
   };
 
-  template <class T, unsigned int NumberComponents>
-  class FieldAllocator<T, NumberComponents, Architecture::GPU, true>
-    : public FieldAllocator<T, NumberComponents, Architecture::Generic, true> {
+  template <class T, unsigned int NumberComponents, bool IsTransformed>
+  class FieldAllocator<T, NumberComponents, Architecture::GPU, true, IsTransformed>
+    : public FieldAllocator<T, NumberComponents, Architecture::Generic, true,
+                            IsTransformed> {
   private:
-    using Base = FieldAllocator<T, NumberComponents, Architecture::Generic, true>;
+    using Base = FieldAllocator<T, NumberComponents, Architecture::Generic, true,
+                                IsTransformed>;
 
   protected:
     DynamicArray<T, Architecture::CPUPinned> array;
@@ -71,22 +85,24 @@ namespace lbm {
   public:
     using Base::IsWritten;
     using Base::fieldName;
+    using Base::getNumberElements;
 
     FieldAllocator(const std::string& fieldName_in)
       : Base(fieldName_in)
-      , array(FFTWInit::numberElements * NumberComponents)
+      , array(Base::getNumberElements() * NumberComponents)
     {}
   };
 
   template <class T, unsigned int NumberComponents, Architecture architecture,
-            bool isWritten>
+            bool isWritten, bool IsTransformed = false>
   class Field {};
 
-  template <class T, unsigned int NumberComponents, Architecture architecture>
-  class Field<T, NumberComponents, architecture, true>
-    : public FieldAllocator<T, NumberComponents, architecture, true> {
+  template <class T, unsigned int NumberComponents, Architecture architecture,
+            bool IsTransformed>
+  class Field<T, NumberComponents, architecture, true, IsTransformed>
+    : public FieldAllocator<T, NumberComponents, architecture, true, IsTransformed> {
   private:
-    using Base = FieldAllocator<T, NumberComponents, architecture, true>;
+    using Base = FieldAllocator<T, NumberComponents, architecture, true, IsTransformed>;
 
   protected:
     using Base::array;
@@ -94,6 +110,7 @@ namespace lbm {
   public:
     using Base::fieldName;
     using Base::IsWritten;
+    using Base::getNumberElements;
     Computation<architecture, L::dimD> computationLocal;
 
     Field(const std::string& fieldName_in)
@@ -108,7 +125,7 @@ namespace lbm {
     {
       T * arrayPtr = array.data();
       computationLocal.Do(stream_in, *this, arrayPtr, value_in,
-                          FFTWInit::numberElements);
+                          getNumberElements());
       computationLocal.synchronize();
     }
 
@@ -120,7 +137,7 @@ namespace lbm {
   {
     T * arrayPtr = array.data();
     computationLocal.Do(stream_in, *this, arrayPtr, vector_in,
-                        FFTWInit::numberElements);
+                        getNumberElements());
     computationLocal.synchronize();
   }
 
@@ -199,13 +216,19 @@ namespace lbm {
     }
   };
 
-  template <class T, unsigned int NumberComponents, Architecture architecture>
-  class Field<T, NumberComponents, architecture, false> {
+  template <class T, unsigned int NumberComponents, Architecture architecture,
+            bool IsTransformed>
+  class Field<T, NumberComponents, architecture, false, IsTransformed> {
   public:
     static constexpr bool IsWritten = false;
 
     const std::string fieldName;
 
+    LBM_HOST
+    static inline unsigned int getNumberElements() {
+      return IsTransformed ? FFTWInit::numberElements : lSD::pVolume();
+    }
+
     Field(const std::string& fieldName_in,
         const MathVector<T, NumberComponents>& vector_in)
       : fieldName(fieldName_in)
@@ -23,8 +23,8 @@ template <class T, Architecture architecture>
 class FieldList {
  public:
   Field<T, 1, architecture, true> density;
-  Field<T, L::dimD, architecture, true> velocity;
-  Field<T, L::dimD, architecture, writeForce> force;
+  Field<T, L::dimD, architecture, true, true> velocity;
+  Field<T, L::dimD, architecture, writeForce, true> force;
   Field<T, 1, architecture, writeAlpha> alpha;
   Field<T, 1, architecture, writeKinetics> T2;
   Field<T, 1, architecture, writeKinetics> T3;
@@ -37,7 +37,9 @@ class FieldList {
   Field<T, 1, architecture, writeKinetics> squaredQContractedPi1;
   Field<T, 1, architecture, writeKinetics> cubedQContractedPi1;
   Field<T, 1, architecture, writeKinetics> fNonEq8;
-  Field<T, 2 * L::dimD - 3, architecture, writeVorticity> vorticity;
+  Field<T, 2 * L::dimD - 3, architecture,
+        writeVorticity || analyzeTotalEnstrophy || getIsSubsetField("vorticity"),
+        true> vorticity;
   FieldWriter_& fieldWriter;
 
 
@@ -60,7 +62,19 @@ class FieldList {
     , fNonEq8("fNonEq_8")
     , vorticity("vorticity")
     , fieldWriter(fieldWriter_in)
-  {}
+  {
+    fieldWriter.setDatasetLayout("vorticity",
+                                 DatasetLayout::getLossy(vorticityErrorBound));
+    fieldWriter.setDatasetLayout("alpha", DatasetLayout::getLossy(alphaErrorBound));
+
+    const std::string kineticsPrefixes[] = {"T2", "T3", "T4", "pi1",
+                                            "squaredQContractedPi1",
+                                            "cubedQContractedPi1", "fNonEq_8"};
+    for (auto iF = 0; iF < 7; ++iF) {
+      fieldWriter.setDatasetLayout(kineticsPrefixes[iF],
+                                   DatasetLayout::getLossy(kineticsErrorBound));
+    }
+  }
 
   inline void writeFields() {
     fieldWriter.writeField(density);
@@ -84,6 +98,26 @@ class FieldList {
     if(writeForce) fieldWriter.writeField(force);
     if(writeVorticity) fieldWriter.writeField(vorticity);
   }
+
+  /// Fields not selected by a due subset are skipped by the writer
+  inline void writeSubsets(SubsetWriter_& subsetWriter) {
+    subsetWriter.writeField(density);
+    subsetWriter.writeField(velocity);
+    subsetWriter.writeField(force);
+    subsetWriter.writeField(alpha);
+    subsetWriter.writeField(T2);
+    subsetWriter.writeField(T3);
+    subsetWriter.writeField(T4);
+    subsetWriter.writeField(T2_approx);
+    subsetWriter.writeField(T3_approx);
+    subsetWriter.writeField(T4_approx);
+    subsetWriter.writeField(pi1Diagonal);
+    subsetWriter.writeField(pi1Symmetric);
+    subsetWriter.writeField(squaredQContractedPi1);
+    subsetWriter.writeField(cubedQContractedPi1);
+    subsetWriter.writeField(fNonEq8);
+    subsetWriter.writeField(vorticity);
+  }
 };
 
 }  // namespace lbm
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <mpi.h>
+
+#include "Commons.h"
+#include "Computation.h"
+#include "Domain.h"
+#include "DynamicArray.h"
+#include "Lattice.h"
+#include "MathVector.h"
+#include "Options.h"
+
+namespace lbm {
+
+  /**
+   * Fourth-order centered finite differences on a local space field.
+   * X is distributed, so the haloWidth planes on each side of the local
+   * block are exchanged with the neighbouring processes; Y and Z are
+   * local and wrap around periodically. Derivatives are scaled to a
+   * domain of length 2 pi to match the spectral operators.
+   *
+   * @tparam T datatype.
+   * @tparam NumberComponents number of components of the differentiated field.
+   */
+  template <class T, unsigned int NumberComponents>
+  class FiniteDifference {
+  public:
+    static constexpr unsigned int haloWidth = 2;
+
+  protected:
+    const T* spaceInPtr;
+    const unsigned int planeVolume;
+    const unsigned int sideVolume;
+    DynamicArray<T, Architecture::CPU> sendArray;
+    DynamicArray<T, Architecture::CPU> haloArray;
+    MathVector<T, 3> scale;
+
+    FiniteDifference(const T* spaceInPtr_in)
+      : spaceInPtr(spaceInPtr_in)
+      , planeVolume(lSD::sLength()[d::Y] * lSD::sLength()[d::Z])
+      , sideVolume(NumberComponents * haloWidth * planeVolume)
+      , sendArray(2 * sideVolume)
+      , haloArray(2 * sideVolume)
+      , scale{{0}}
+    {
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        scale[iD] = gSD::sLength()[iD] / (2 * M_PI);
+      }
+    }
+
+    /// Left halo holds planes -2, -1 and right halo planes lX, lX + 1
+    LBM_HOST
+    inline void exchangeHalo(const unsigned int numberElements) {
+      const unsigned int lengthX = lSD::sLength()[d::X];
+
+      for (auto iC = 0; iC < NumberComponents; ++iC) {
+        for (auto iH = 0; iH < haloWidth; ++iH) {
+          for (auto iYZ = 0; iYZ < planeVolume; ++iYZ) {
+            Position iP_left{{0}};
+            iP_left[d::X] = iH;
+            iP_left[d::Y] = iYZ / lSD::sLength()[d::Z];
+            iP_left[d::Z] = iYZ % lSD::sLength()[d::Z];
+
+            Position iP_right = iP_left;
+            iP_right[d::X] = lengthX - haloWidth + iH;
+            const unsigned int indexHalo = (iC * haloWidth + iH) * planeVolume + iYZ;
+
+            sendArray[indexHalo] =
+              (spaceInPtr + iC * numberElements)[lSD::getIndex(iP_left)];
+            sendArray[sideVolume + indexHalo] =
+              (spaceInPtr + iC * numberElements)[lSD::getIndex(iP_right)];
+          }
+        }
+      }
+
+      MPI_Sendrecv(sendArray.data(), sideVolume, MPI_DOUBLE, MPIInit::rankLeft, 41,
+                   haloArray.data(sideVolume), sideVolume, MPI_DOUBLE,
+                   MPIInit::rankRight, 41, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      MPI_Sendrecv(sendArray.data(sideVolume), sideVolume, MPI_DOUBLE,
+                   MPIInit::rankRight, 42, haloArray.data(), sideVolume,
+                   MPI_DOUBLE, MPIInit::rankLeft, 42, MPI_COMM_WORLD,
+                   MPI_STATUS_IGNORE);
+    }
+
+    LBM_HOST
+    inline T getShiftedValue(const Position& iP, const int shift,
+                             const unsigned int iD, const unsigned int iC,
+                             const unsigned int numberElements) {
+      Position iP_shifted = iP;
+      const int lengthD = lSD::sLength()[iD];
+      const int iShifted = (int)iP[iD] + shift;
+
+      if (iD == d::X && iShifted < 0) {
+        return haloArray[(iC * haloWidth + iShifted + haloWidth) * planeVolume
+                         + iP[d::Y] * lSD::sLength()[d::Z] + iP[d::Z]];
+      }
+      else if (iD == d::X && iShifted >= lengthD) {
+        return haloArray[sideVolume
+                         + (iC * haloWidth + iShifted - lengthD) * planeVolume
+                         + iP[d::Y] * lSD::sLength()[d::Z] + iP[d::Z]];
+      }
+
+      iP_shifted[iD] = (iShifted + lengthD) % lengthD;
+      return (spaceInPtr + iC * numberElements)[lSD::getIndex(iP_shifted)];
+    }
+
+    /// Derivative of component iC along iD at iP
+    LBM_HOST
+    inline T derivative(const Position& iP, const unsigned int iD,
+                        const unsigned int iC, const unsigned int numberElements) {
+      return scale[iD] *
+        (8 * (getShiftedValue(iP, 1, iD, iC, numberElements)
+              - getShiftedValue(iP, -1, iD, iC, numberElements))
+         - (getShiftedValue(iP, 2, iD, iC, numberElements)
+            - getShiftedValue(iP, -2, iD, iC, numberElements))) / 12;
+    }
+  };
+
+  template <class T, unsigned int Dimension>
+  class FiniteDifferenceCurl {};
+
+  template <class T>
+  class FiniteDifferenceCurl<T, 2> : public FiniteDifference<T, 2> {
+  private:
+    using Base = FiniteDifference<T, 2>;
+
+    T* spaceOutPtr;
+    Computation<Architecture::CPU, 2> computationLocal;
+
+  public:
+    FiniteDifferenceCurl(const T* spaceInPtr_in, T* spaceOutPtr_in)
+      : Base(spaceInPtr_in)
+      , spaceOutPtr(spaceOutPtr_in)
+      , computationLocal(lSD::sStart(), lSD::sEnd())
+    {}
+
+    LBM_HOST
+    inline void execute(const unsigned int numberElements) {
+      Base::exchangeHalo(numberElements);
+
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
+          spaceOutPtr[lSD::getIndex(iP)] =
+            Base::derivative(iP, d::X, d::Y, numberElements)
+            - Base::derivative(iP, d::Y, d::X, numberElements);
+      });
+      computationLocal.synchronize();
+    }
+  };
+
+  template <class T>
+  class FiniteDifferenceCurl<T, 3> : public FiniteDifference<T, 3> {
+  private:
+    using Base = FiniteDifference<T, 3>;
+
+    T* spaceOutPtr;
+    Computation<Architecture::CPU, 3> computationLocal;
+
+  public:
+    FiniteDifferenceCurl(const T* spaceInPtr_in, T* spaceOutPtr_in)
+      : Base(spaceInPtr_in)
+      , spaceOutPtr(spaceOutPtr_in)
+      , computationLocal(lSD::sStart(), lSD::sEnd())
+    {}
+
+    LBM_HOST
+    inline void execute(const unsigned int numberElements) {
+      Base::exchangeHalo(numberElements);
+
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
+          const auto index = lSD::getIndex(iP);
+
+          for (auto iD = 0; iD < 3; ++iD) {
+            const auto iD1 = (iD + 1) % 3;
+            const auto iD2 = (iD + 2) % 3;
+            (spaceOutPtr + iD * numberElements)[index] =
+              Base::derivative(iP, iD1, iD2, numberElements)
+              - Base::derivative(iP, iD2, iD1, numberElements);
+          }
+      });
+      computationLocal.synchronize();
+    }
+  };
+
+}  // namespace lbm
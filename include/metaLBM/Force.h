@@ -9,10 +9,12 @@
 #include "Commons.h"
 #include "DynamicArray.h"
 #include "FourierDomain.h"
+#include "FourierIndex.h"
 #include "FieldList.h"
 #include "Lattice.h"
 #include "MathVector.h"
 #include "Options.h"
+#include "ShellSum.h"
 
 namespace lbm {
 
@@ -168,7 +170,7 @@ namespace lbm {
           auto index = lSD::getIndex(iP);
 
           MathVector<T, L::dimD> force;
-          setForce(iP + offset, force);
+          setForce(forcePtr, iP, force, FFTWInit::numberElements);
           for (auto iD = 0; iD < L::dimD; ++iD) {
             (forcePtr + iD * FFTWInit::numberElements)[index] = force[iD];
           }
@@ -191,6 +193,8 @@ namespace lbm {
     using Base::offset;
     using Base::amplitude;
     MathVector<T, L::dimD> waveLength;
+    MathVector<unsigned int, L::dimD> profileStart;
+    DynamicArray<T, Architecture::CPU> profileArray;
 
   public:
     Force(const Position& offset_in,
@@ -198,19 +202,22 @@ namespace lbm {
           const MathVector<T, 3>& waveLength_in,
           const unsigned int kMin_in,
           const unsigned int kMax_in)
-      : Base(offset_in, amplitude_in), waveLength{(T)0}
+      : Base(offset_in, amplitude_in), waveLength{(T)0}, profileStart{{0}}
+      , profileArray(lSD::sLength().sum())
     {
       for (auto iD = 0; iD < L::dimD; ++iD) {
         waveLength[iD] = waveLength_in[iD];
       }
+      initProfileArray();
     }
 
+    /// iP is the local position, the profiles already hold the offset
     LBM_DEVICE LBM_HOST inline void setForce(T* forceArray,
                                              const Position& iP,
                                              MathVector<T, L::dimD>& force,
                                              const unsigned int numberElements) {
       for (auto iD = 0; iD < L::dimD; ++iD) {
-        force[iD] = amplitude[iD] * sin(iP[iD] * 2 * M_PI / waveLength[iD]);
+        force[iD] = profileArray[profileStart[iD] + iP[iD]];
       }
     }
 
@@ -219,13 +226,15 @@ namespace lbm {
                               FieldList<T, architecture>& fieldList) {
       Computation<Architecture::CPU, L::dimD> computationLocal(lSD::sStart(),
                                                                lSD::sEnd());
+      unsigned int numberElements = FFTWInit::numberElements;
+
       computationLocal.Do([=] LBM_HOST(const Position& iP) {
           MathVector<T, L::dimD> force;
 
           auto index = lSD::getIndex(iP);
-          setForce(iP + offset, force);
+          setForce(forcePtr, iP, force, numberElements);
           for (auto iD = 0; iD < L::dimD; ++iD) {
-            (forcePtr + iD * FFTWInit::numberElements)[index] = force[iD];
+            (forcePtr + iD * numberElements)[index] = force[iD];
           }
         });
       computationLocal.synchronize();
@@ -234,6 +243,20 @@ namespace lbm {
 
     using Base::setForce;
     using Base::update;
+
+  private:
+    /// One sine per local position of each axis, computed once
+    inline void initProfileArray() {
+      unsigned int start = 0;
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        profileStart[iD] = start;
+        for (auto i = 0; i < lSD::sLength()[iD]; ++i) {
+          profileArray[start + i] = amplitude[iD]
+            * sin((i + offset[iD]) * 2 * M_PI / waveLength[iD]);
+        }
+        start += lSD::sLength()[iD];
+      }
+    }
   };
 
   template <class T, Architecture architecture>
@@ -245,6 +268,7 @@ namespace lbm {
     using Base::offset;
     using Base::amplitude;
     MathVector<T, L::dimD> waveLength;
+    DynamicArray<T, Architecture::CPU> profileArray;
 
   public:
     Force(const Position& offset_in,
@@ -253,17 +277,24 @@ namespace lbm {
           const unsigned int kMin_in,
           const unsigned int kMax_in)
       : Base(offset_in, amplitude_in), waveLength{(T)0}
+      , profileArray(lSD::sLength()[d::Y])
     {
       for (auto iD = 0; iD < L::dimD; ++iD) {
         waveLength[iD] = waveLength_in[iD];
       }
+
+      for (auto iY = 0; iY < lSD::sLength()[d::Y]; ++iY) {
+        profileArray[iY] = amplitude[d::X]
+          * sin((iY + offset[d::Y]) * 2 * M_PI / waveLength[d::X]);
+      }
     }
 
+    /// iP is the local position, the profile already holds the offset
     LBM_DEVICE LBM_HOST void setForce(T* forcePtr,
                                       const Position& iP,
                                       MathVector<T, L::dimD>& force,
                                       const unsigned int numberElements) {
-      force[d::X] = amplitude[d::X] * sin(iP[d::Y] * 2 * M_PI / waveLength[d::X]);
+      force[d::X] = profileArray[iP[d::Y]];
     }
 
     LBM_HOST
@@ -275,9 +306,9 @@ namespace lbm {
       unsigned int numberElements = FFTWInit::numberElements;
 
       computationLocal.Do([=] LBM_HOST(const Position& iP) {
-          MathVector<T, L::dimD> force;
+          MathVector<T, L::dimD> force{{0}};
           auto index = lSD::getIndex(iP);
-          setForce(forcePtr, iP + offset, force, numberElements);
+          setForce(forcePtr, iP, force, numberElements);
 
           for (auto iD = 0; iD < L::dimD; ++iD) {
             (forcePtr + iD * numberElements)[index] = force[iD];
@@ -300,6 +331,8 @@ namespace lbm {
     using Base = Force<double, ForceType::GenericTimeIndependent, architecture>;
 
     const unsigned int kMin, kMax;
+    const bool isDirectSum;
+    ShellSum<L::dimD> shellSum;
     DynamicArray<double, Architecture::CPU> tempArray;
 
 
@@ -313,103 +346,84 @@ namespace lbm {
           const MathVector<double, 3>& waveLength_in,
           const unsigned int kMin_in,
           const unsigned int kMax_in)
+      : Force(offset_in, amplitude_in, waveLength_in, kMin_in, kMax_in,
+              ShellSum<L::dimD>::getIsCheaperThanFFT(
+                ShellSum<L::dimD>::getNumberModes(kMin_in, kMax_in)))
+    {}
+
+    /// Forces the direct sum or the FFT path, to compare them
+    Force(const Position& offset_in,
+          const MathVector<double, 3>& amplitude_in,
+          const MathVector<double, 3>& waveLength_in,
+          const unsigned int kMin_in,
+          const unsigned int kMax_in,
+          const bool isDirectSum_in)
       : Base(offset_in, amplitude_in), kMin(kMin_in), kMax(kMax_in)
-      , tempArray((2 * L::dimD - 3) * FFTWInit::numberElements)
+      , isDirectSum(isDirectSum_in)
+      // Left empty, without tables, when the FFT path is used
+      , shellSum(isDirectSum ? kMin_in : 1, isDirectSum ? kMax_in : 0, offset_in)
+      , tempArray(isDirectSum ? 0 : (2 * L::dimD - 3) * FFTWInit::numberElements)
     {
-      initTempArray();
+      if (isDirectSum) initShellSum();
+      else initTempArray();
     }
 
     inline void setForceArray(double * forcePtr,
                               FieldList<double, architecture>& fieldList) {
+      setForceArray(forcePtr);
+    }
+
+    inline void setForceArray(double * forcePtr) {
+      if (isDirectSum) {
+        shellSum.execute(forcePtr, FFTWInit::numberElements);
+        return;
+      }
+
       double* spaceTempPtr = tempArray.data();
 
       MakeIncompressible<double, Architecture::CPU, PartitionningType::OneD, L::dimD>
-        makeIncompressible(spaceTempPtr, forcePtr, globalLengthPtrdiff_t, offset);
+        makeIncompressible(spaceTempPtr, forcePtr, globalLengthPtrdiff_t,
+                           gFD::offset(MPIInit::rank));
 
       makeIncompressible.executeFourier();
     }
 
+    /// Curl of the real amplitude on each mode, i k x amplitude
+    inline void initShellSum() {
+      for (auto iM = 0; iM < shellSum.size(); ++iM) {
+        const WaveNumber& iK = shellSum.getWaveNumber(iM);
+
+        if (L::dimD == 2) {
+          shellSum.setCoefficient(iM, d::X, 0.0, iK[d::Y] * amplitude[0]);
+          shellSum.setCoefficient(iM, d::Y, 0.0, -iK[d::X] * amplitude[0]);
+        }
+        else {
+          for (auto iD = 0; iD < L::dimD; ++iD) {
+            const auto iD1 = (iD + 1) % 3;
+            const auto iD2 = (iD + 2) % 3;
+            shellSum.setCoefficient(iM, iD, 0.0, iK[iD1] * amplitude[iD2]
+                                    - iK[iD2] * amplitude[iD1]);
+          }
+        }
+      }
+    }
+
     inline void initTempArray() {
       double* spaceTempPtr = tempArray.data();
+      memset(spaceTempPtr, 0, tempArray.size() * sizeof(double));
 
-      Computation<Architecture::CPU, L::dimD> computationFourier(lFD::start(),
-                                                                 lFD::end());
-
-      computationFourier.Do([=] LBM_HOST(const Position& iFP) {
-          int kNormSquared;
-          WaveNumber iK{{0}};
-          Position iFP_symmetric{{0}};
-          WaveNumber iK_symmetric{{0}};
-
-          auto index = lFD::getIndex(iFP);
-
-          iK[d::X] = iFP[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-            ? iFP[d::X] + offset[d::X] : iFP[d::X] + offset[d::X] - gSD::sLength()[d::X];
-          iK[d::Y] = iFP[d::Y] <= gSD::sLength()[d::Y] / 2
-            ? iFP[d::Y] : iFP[d::Y] - gSD::sLength()[d::Y];
-          iK[d::Z] = iFP[d::Z] <= gSD::sLength()[d::Z] / 2
-            ? iFP[d::Z] : iFP[d::Z] - gSD::sLength()[d::Z];
-
-          for (auto iD = 0; iD < 2 * L::dimD - 3; ++iD) {
-            fftw_complex* fourierTempPtr =
-              (fftw_complex*)(spaceTempPtr + iD * FFTWInit::numberElements);
-
-            fourierTempPtr[index][p::Re] = 0.0;
-            fourierTempPtr[index][p::Im] = 0.0;
-
-            if (iFP[L::dimD - 1] == 0) {
-              iFP_symmetric[d::X] = gSD::sLength()[d::X] - iFP[d::X];
-              if (iFP_symmetric[d::X] < lFD::length()[d::X]) {
-                iFP_symmetric[d::Y] = gSD::sLength()[d::Y] - iFP[d::Y];
-                iFP_symmetric[L::dimD - 1] = 0;
-
-                iK_symmetric[d::X] =
-                  iFP_symmetric[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-                  ? iFP_symmetric[d::X] + offset[d::X]
-                  : iFP_symmetric[d::X] + offset[d::X] - gSD::sLength()[d::X];
-                iK_symmetric[d::Y] = iFP_symmetric[d::Y] <= gSD::sLength()[d::Y] / 2
-                  ? iFP_symmetric[d::Y] : iFP_symmetric[d::Y] - gSD::sLength()[d::Y];
-
-                auto index_symmetric = lFD::getIndex(iFP_symmetric);
-                fourierTempPtr[index_symmetric][p::Re] = 0.0;
-                fourierTempPtr[index_symmetric][p::Im] = 0.0;
-              }
-            }
-          }
+      const FourierShell fourierShell =
+        FourierIndex::getInstance().getShell(kMin, kMax);
 
-          kNormSquared = iK.norm2();
-          if (kNormSquared >= kMin * kMin && kNormSquared <= kMax * kMax) {
-            for (auto iD = 0; iD < 2 * L::dimD - 3; ++iD) {
-              fftw_complex* fourierTempPtr =
-                (fftw_complex*)(spaceTempPtr + iD * FFTWInit::numberElements);
-
-              fourierTempPtr[index][p::Re] = amplitude[iD];
-              fourierTempPtr[index][p::Im] = 0.0;
-
-              if (iFP[L::dimD - 1] == 0) {
-                iFP_symmetric[d::X] = gSD::sLength()[d::X] - iFP[d::X];
-                if (iFP_symmetric[d::X] < lFD::length()[d::X]) {
-                  iFP_symmetric[d::Y] = gSD::sLength()[d::Y] - iFP[d::Y];
-                  iFP_symmetric[L::dimD - 1] = 0;
-
-                  iK_symmetric[d::X] =
-                    iFP_symmetric[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-                    ? iFP_symmetric[d::X] + offset[d::X]
-                    : iFP_symmetric[d::X] + offset[d::X] - gSD::sLength()[d::X];
-                  iK_symmetric[d::Y] =
-                    iFP_symmetric[d::Y] <= gSD::sLength()[d::Y] / 2
-                    ? iFP_symmetric[d::Y] : iFP_symmetric[d::Y] - gSD::sLength()[d::Y];
-
-                  auto index_symmetric = lFD::getIndex(iFP_symmetric);
-                  fourierTempPtr[index_symmetric][p::Re] = amplitude[iD];
-                  fourierTempPtr[index_symmetric][p::Im] = 0.0;
-                }
-              }
-            }
-          }
-      });
+      for (auto iD = 0; iD < 2 * L::dimD - 3; ++iD) {
+        fftw_complex* fourierTempPtr =
+          (fftw_complex*)(spaceTempPtr + iD * FFTWInit::numberElements);
 
-      computationFourier.synchronize();
+        for (auto iS = 0; iS < fourierShell.size(); ++iS) {
+          fourierTempPtr[fourierShell.indices[iS]][p::Re] = amplitude[iD];
+          fourierTempPtr[fourierShell.indices[iS]][p::Im] = 0.0;
+        }
+      }
     }
 
     using Base::setForce;
@@ -424,6 +438,7 @@ namespace lbm {
     using Base = Force<double, ForceType::GenericTimeDependent, architecture>;
 
     const unsigned int kMin, kMax;
+    const FourierShell fourierShell;
 
   protected:
     using Base::offset;
@@ -435,7 +450,9 @@ namespace lbm {
           const MathVector<double, 3>& waveLength_in,
           const unsigned int kMin_in,
           const unsigned int kMax_in)
-      : Base(offset_in, amplitude_in), kMin(kMin_in), kMax(kMax_in) {}
+      : Base(offset_in, amplitude_in), kMin(kMin_in), kMax(kMax_in)
+      , fourierShell(FourierIndex::getInstance().getShell(kMin_in, kMax_in))
+    {}
 
     inline void setForceArray(double * forcePtr,
                               FieldList<double, architecture>& fieldList) {
@@ -450,7 +467,7 @@ namespace lbm {
       Computation<Architecture::CPU, L::dimD> computationLocal(lSD::sStart(),
                                                                lSD::sEnd());
 
-      computationLocal.Do([=] LBM_HOST(const Position& iP) {
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
           const auto index = lSD::getIndex(iP);
 
           for (auto iD = 0; iD < L::dimD; ++iD) {
@@ -465,90 +482,23 @@ namespace lbm {
                  L::dimD, L::dimD> forward(momentumPtr, globalLengthPtrdiff_t);
       forward.execute();
 
-      Computation<Architecture::CPU, L::dimD> computationFourier(lFD::start(),
-                                                                 lFD::end());
-
-      computationFourier.Do([=] LBM_HOST(const Position& iFP) {
-          int kNormSquared;
-          WaveNumber iK{{0}};
-          Position iFP_symmetric{{0}};
-          WaveNumber iK_symmetric{{0}};
-          auto index = lFD::getIndex(iFP);
-
-          iK[d::X] = iFP[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-            ? iFP[d::X] + offset[d::X] : iFP[d::X] + offset[d::X] - gSD::sLength()[d::X];
-          iK[d::Y] = iFP[d::Y] <= gSD::sLength()[d::Y] / 2
-            ? iFP[d::Y] : iFP[d::Y] - gSD::sLength()[d::Y];
-          iK[d::Z] = iFP[d::Z] <= gSD::sLength()[d::Z] / 2
-            ? iFP[d::Z] : iFP[d::Z] - gSD::sLength()[d::Z];
-
-          for (auto iD = 0; iD < L::dimD; ++iD) {
-            fftw_complex* fourierForcePtr_iD =
-              (fftw_complex*)(forcePtr + iD * numberElements);
-
-            fourierForcePtr_iD[index][p::Re] = 0.0;
-            fourierForcePtr_iD[index][p::Im] = 0.0;
-
-            if (iFP[L::dimD - 1] == 0) {
-              iFP_symmetric[d::X] = gSD::sLength()[d::X] - iFP[d::X];
-              if (iFP_symmetric[d::X] < lFD::length()[d::X]) {
-                iFP_symmetric[d::Y] = gSD::sLength()[d::Y] - iFP[d::Y];
-                iFP_symmetric[L::dimD - 1] = 0;
-
-                iK_symmetric[d::X] =
-                  iFP_symmetric[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-                  ? iFP_symmetric[d::X] + offset[d::X]
-                  : iFP_symmetric[d::X] + offset[d::X] - gSD::sLength()[d::X];
-                iK_symmetric[d::Y] = iFP_symmetric[d::Y] <= gSD::sLength()[d::Y] / 2
-                  ? iFP_symmetric[d::Y] : iFP_symmetric[d::Y] - gSD::sLength()[d::Y];
-
-                auto index_symmetric = lFD::getIndex(iFP_symmetric);
-                fourierForcePtr_iD[index_symmetric][p::Re] = 0.0;
-                fourierForcePtr_iD[index_symmetric][p::Im] = 0.0;
-              }
-            }
-          }
+      memset(forcePtr, 0, L::dimD * numberElements * sizeof(double));
 
-          kNormSquared = iK.norm2();
-          if (kNormSquared >= kMin * kMin && kNormSquared <= kMax * kMax) {
-            for (auto iD = 0; iD < L::dimD; ++iD) {
-              fftw_complex* fourierForcePtr_iD =
-                (fftw_complex*)(forcePtr + iD * numberElements);
-              fftw_complex* fourierMomentumPtr_iD =
-                (fftw_complex*)(momentumPtr + iD * numberElements);
-
-              fourierForcePtr_iD[index][p::Re] =
-                - amplitude[iD] * fourierMomentumPtr_iD[index][p::Re];
-              fourierForcePtr_iD[index][p::Im] =
-                - amplitude[iD] * fourierMomentumPtr_iD[index][p::Im];
-
-              if (iFP[L::dimD - 1] == 0) {
-                iFP_symmetric[d::X] = gSD::sLength()[d::X] - iFP[d::X];
-                if (iFP_symmetric[d::X] < lFD::length()[d::X]) {
-                  iFP_symmetric[d::Y] = gSD::sLength()[d::Y] - iFP[d::Y];
-                  iFP_symmetric[L::dimD - 1] = 0;
-
-                  iK_symmetric[d::X] =
-                    iFP_symmetric[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-                    ? iFP_symmetric[d::X] + offset[d::X]
-                    : iFP_symmetric[d::X] + offset[d::X] -
-                    gSD::sLength()[d::X];
-                  iK_symmetric[d::Y] =
-                    iFP_symmetric[d::Y] <= gSD::sLength()[d::Y] / 2
-                    ? iFP_symmetric[d::Y]
-                    : iFP_symmetric[d::Y] - gSD::sLength()[d::Y];
-
-                  auto index_symmetric = lFD::getIndex(iFP_symmetric);
-                  fourierForcePtr_iD[index_symmetric][p::Re] =
-                    - amplitude[iD] * fourierMomentumPtr_iD[index_symmetric][p::Re];
-                  fourierForcePtr_iD[index_symmetric][p::Im] =
-                    - amplitude[iD] * fourierMomentumPtr_iD[index_symmetric][p::Im];
-                }
-              }
-            }
-          }
-        });
-      computationFourier.synchronize();
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        fftw_complex* fourierForcePtr_iD =
+          (fftw_complex*)(forcePtr + iD * numberElements);
+        fftw_complex* fourierMomentumPtr_iD =
+          (fftw_complex*)(momentumPtr + iD * numberElements);
+
+        #pragma omp parallel for schedule(static)
+        for (auto iS = 0; iS < fourierShell.size(); ++iS) {
+          const unsigned int index = fourierShell.indices[iS];
+          fourierForcePtr_iD[index][p::Re] =
+            - amplitude[iD] * fourierMomentumPtr_iD[index][p::Re];
+          fourierForcePtr_iD[index][p::Im] =
+            - amplitude[iD] * fourierMomentumPtr_iD[index][p::Im];
+        }
+      }
 
       BackwardFFT<double, Architecture::CPU, PartitionningType::OneD,
                   L::dimD, L::dimD> backward(forcePtr, globalLengthPtrdiff_t);
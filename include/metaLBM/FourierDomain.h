@@ -14,6 +14,13 @@ namespace lbm {
  * @tparam memoryLayout type of memory layout used.
  */
 
+/// FFTW_MPI_TRANSPOSED_OUT swaps the first two dimensions, only used in 3D
+constexpr bool isFourierTransposed = useFFTWTransposed && L::dimD == 3;
+
+/// The transposed local domain assumes FFTW splits Y evenly across processes
+static_assert(!isFourierTransposed || globalLengthY % numProcs == 0,
+              "useFFTWTransposed requires globalLengthY divisible by numProcs");
+
 template <PartitionningType partitionningType, unsigned int NumberComponents>
 struct Domain<DomainType::LocalFourier,
               partitionningType,
@@ -25,8 +32,12 @@ struct Domain<DomainType::LocalFourier,
   }
 
   LBM_HOST LBM_DEVICE static inline constexpr Position end() {
-    return ProjectPadComplexAndLeave1<unsigned int, L::dimD>::Do(
-        lSD::sLength());
+    return isFourierTransposed
+      ? ProjectPadComplexAndLeave1<unsigned int, L::dimD>::Do(
+          {{gSD::sLength()[d::X], gSD::sLength()[d::Y] / numProcs,
+            gSD::sLength()[d::Z]}})
+      : ProjectPadComplexAndLeave1<unsigned int, L::dimD>::Do(
+          lSD::sLength());
   }
 
   LBM_HOST LBM_DEVICE static inline constexpr Position length() {
@@ -37,8 +48,24 @@ struct Domain<DomainType::LocalFourier,
     return length()[d::X] * length()[d::Y] * length()[d::Z];
   }
 
+  /// Dimension split across processes, Y when the output is transposed
+  LBM_HOST LBM_DEVICE static inline constexpr unsigned int distributedDimension() {
+    return isFourierTransposed ? d::Y : d::X;
+  }
+
+  /// Start of the local block in the global Fourier domain
+  LBM_HOST LBM_DEVICE static inline Position offset(const MathVector<int, 3>& rank) {
+    Position offsetR{{0}};
+    offsetR[distributedDimension()] =
+      (unsigned int)length()[distributedDimension()] * rank[d::X];
+
+    return offsetR;
+  }
+
   LBM_HOST LBM_DEVICE static inline unsigned int getIndex(const Position& iP) {
-    return length()[d::Z] * (length()[d::Y] * iP[d::X] + iP[d::Y]) + iP[d::Z];
+    return isFourierTransposed
+      ? length()[d::Z] * (length()[d::X] * iP[d::Y] + iP[d::X]) + iP[d::Z]
+      : length()[d::Z] * (length()[d::Y] * iP[d::X] + iP[d::Y]) + iP[d::Z];
   }
 };
 
@@ -78,13 +105,19 @@ struct Domain<DomainType::GlobalFourier,
     return arrayMax(globalLengthInt) / 2;
   }
 
-  LBM_HOST LBM_DEVICE static inline Position offset(const MathVector<int, 3>& rank) {
-    Position offsetR{{0}};
+  using Base::offset;
+
+  /// Signed wavenumber of a local Fourier position
+  LBM_HOST LBM_DEVICE static inline WaveNumber getWaveNumber(const Position& iFP,
+                                                             const Position& offset) {
+    WaveNumber iK{{0}};
     for (auto iD = 0; iD < L::dimD; ++iD) {
-      offsetR[iD] = (unsigned int)Base::length()[iD] * rank[iD];
+      const int iFPGlobal = iFP[iD] + offset[iD];
+      iK[iD] = iFPGlobal <= gSD::sLength()[iD] / 2
+        ? iFPGlobal : iFPGlobal - gSD::sLength()[iD];
     }
 
-    return offsetR;
+    return iK;
   }
 
   LBM_HOST LBM_DEVICE static inline unsigned int getIndex(const Position& iP) {
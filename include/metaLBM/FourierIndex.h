@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+
+#include "Commons.h"
+#include "Computation.h"
+#include "DynamicArray.h"
+#include "FourierDomain.h"
+#include "MathVector.h"
+
+namespace lbm {
+
+  /// Local Fourier modes whose wavenumber norm lies within [kMin, kMax]
+  struct FourierShell {
+    std::vector<unsigned int> indices;
+    std::vector<WaveNumber> waveNumbers;
+
+    inline unsigned int size() const { return indices.size(); }
+  };
+
+  /**
+   * Per-process index of the local Fourier modes, computed once and shared
+   * by spectral analyses and forces. Each mode stores the shell it falls in
+   * and its Hermitian weight: modes with a zero last wavenumber stand for
+   * themselves only and count half.
+   */
+  class FourierIndex {
+  private:
+    DynamicArray<unsigned int, Architecture::CPU> shellArray;
+    DynamicArray<double, Architecture::CPU> weightArray;
+    const Position offset;
+    Computation<Architecture::CPU, L::dimD> computationFourier;
+
+    FourierIndex()
+      : shellArray(lFD::volume())
+      , weightArray(lFD::volume())
+      , offset(gFD::offset(MPIInit::rank))
+      , computationFourier(lFD::start(), lFD::end())
+    {
+      unsigned int* shellPtr = shellArray.data();
+      double* weightPtr = weightArray.data();
+
+      computationFourier.Do([&] LBM_HOST(const Position& iFP) {
+          const auto index = lFD::getIndex(iFP);
+          const WaveNumber iK = gFD::getWaveNumber(iFP, offset);
+
+          shellPtr[index] = iK.norm();
+          weightPtr[index] = iK[L::dimD - 1] == 0 ? 0.5 : 1.0;
+      });
+      computationFourier.synchronize();
+    }
+
+  public:
+    /// Built on first use, once MPI and FFTW are initialized
+    static inline FourierIndex& getInstance() {
+      static FourierIndex fourierIndex;
+      return fourierIndex;
+    }
+
+    inline unsigned int size() const {
+      return shellArray.size();
+    }
+
+    inline const unsigned int* getShellPtr() const {
+      return shellArray.data();
+    }
+
+    inline const double* getWeightPtr() const {
+      return weightArray.data();
+    }
+
+    /// Compact list of the local modes to force, with their wavenumbers
+    inline FourierShell getShell(const unsigned int kMin, const unsigned int kMax) {
+      FourierShell fourierShell;
+
+      computationFourier.Do([&] LBM_HOST(const Position& iFP) {
+          const WaveNumber iK = gFD::getWaveNumber(iFP, offset);
+          const unsigned int kNormSquared = iK.norm2();
+
+          if (kNormSquared >= kMin * kMin && kNormSquared <= kMax * kMax) {
+            fourierShell.indices.push_back(lFD::getIndex(iFP));
+            fourierShell.waveNumbers.push_back(iK);
+          }
+      });
+      computationFourier.synchronize();
+
+      return fourierShell;
+    }
+  };
+
+}  // namespace lbm
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <string>
 
+#include "BuddyCheckpoint.h"
 #include "Commons.h"
 #include "Domain.h"
 #include "DynamicArray.cuh"
@@ -39,7 +40,8 @@ namespace lbm {
         center[d::Z] =
           static_cast<unsigned int>((lSD::sLength()[d::Z] - 1) * (T)0.2);
 
-        densityFieldR.setValue(center, densityPeakValue, FFTWInit::numberElements);
+        densityFieldR.setValue(center, densityPeakValue,
+                               densityFieldR.getNumberElements());
       }
       break;
     }
@@ -49,14 +51,14 @@ namespace lbm {
   }
 
   template <class T, Architecture architecture>
-  Field<T, L::dimD, architecture, true> initVelocity(
+  Field<T, L::dimD, architecture, true, true> initVelocity(
     const Stream<architecture>& stream) {
     LBM_INSTRUMENT_ON("initVelocity<T>", 2)
 
     MathVector<T, L::dimD> initVelocityVectorProjected{{(T)0}};
     initVelocityVectorProjected = Project<T, T, L::dimD>::Do(initVelocityVector);
 
-    Field<T, L::dimD, architecture, true> velocityFieldR(
+    Field<T, L::dimD, architecture, true, true> velocityFieldR(
       "velocity", initVelocityVectorProjected, stream);
 
     switch (initVelocityT) {
@@ -70,10 +72,11 @@ namespace lbm {
   }
 
   template <class T, Architecture architecture>
-  Field<T, L::dimD, architecture, writeForce> initForce(const Stream<architecture>& stream) {
+  Field<T, L::dimD, architecture, writeForce, true>
+  initForce(const Stream<architecture>& stream) {
     LBM_INSTRUMENT_ON("initForce<T>", 2)
 
-    Field<T, L::dimD, architecture, writeForce>
+    Field<T, L::dimD, architecture, writeForce, true>
       forceFieldR("force", 0, stream);
 
     return forceFieldR;
@@ -91,36 +94,41 @@ namespace lbm {
   template <class T, Architecture architecture>
   Distribution<T, architecture> initDistribution(
     Field<T, 1, architecture, true>& densityField,
-    Field<T, L::dimD, architecture, true>& velocityField,
+    Field<T, L::dimD, architecture, true, true>& velocityField,
     const Stream<architecture>& stream) {
     LBM_INSTRUMENT_ON("initDistribution<T>", 2)
 
     Distribution<T, architecture> distributionR;
 
     Computation<architecture, L::dimD> computationLocal(lSD::sStart(), lSD::sEnd());
-    unsigned int numberElements = FFTWInit::numberElements;
-    T * distributionPtr = distributionR.getData(FFTWInit::numberElements);
-    T * densityPtr = densityField.getData(FFTWInit::numberElements);
-    T * velocityPtr = velocityField.getData(FFTWInit::numberElements);
+    unsigned int numberElements = velocityField.getNumberElements();
+    T * haloDistributionPtr = distributionR.getHaloDataNext();
+    T * densityPtr = densityField.getData(densityField.getNumberElements());
+    T * velocityPtr = velocityField.getData(numberElements);
 
     if (startIteration == 0) {
       computationLocal.Do(stream, [=] LBM_HOST LBM_DEVICE (const Position& iP) {
-        T density = densityField.getValue(iP, numberElements);
+        T density = densityPtr[lSD::getIndex(iP)];
         MathVector<T, L::dimD> velocity = velocityField.getVector(iP, numberElements);
         T velocity2 = velocity.norm2();
 
         for(auto iQ = 0; iQ < L::dimQ; ++iQ) {
-          distributionPtr[iQ * numberElements + lSD::getIndex(iP)] =
+          haloDistributionPtr[hSD::getIndex(iP + L::halo(), iQ)] =
             Equilibrium_::calculate(density, velocity, velocity2, iQ);
         }
         });
     }
 
     else {
-      DistributionReader_ distributionReader(prefix);
-      distributionReader.openFile(startIteration);
-      distributionReader.readDistribution(distributionR);
-      distributionReader.closeFile();
+      BuddyCheckpoint<T, architecture> buddyCheckpoint;
+      if (!buddyCheckpoint.restore(startIteration, distributionR,
+                                   haloDistributionPtr, stream)) {
+        DistributionReader_ distributionReader(prefix);
+        distributionReader.openFile(startIteration);
+        distributionReader.readDistribution(distributionR, haloDistributionPtr,
+                                            stream);
+        distributionReader.closeFile();
+      }
 
       computationLocal.Do(stream, [=] LBM_HOST LBM_DEVICE (const Position& iP) {
           unsigned int indexLocal = lSD::getIndex(iP);
@@ -132,12 +140,14 @@ namespace lbm {
           }
 
           for(auto iQ = 0; iQ < L::dimQ; ++iQ) {
-            densityPtr[indexLocal] +=
-              distributionPtr[iQ * numberElements + indexLocal];
+            const T distribution_iQ =
+              haloDistributionPtr[hSD::getIndex(iP + L::halo(), iQ)];
+
+            densityPtr[indexLocal] += distribution_iQ;
 
             for(auto iD = 0; iD < L::dimD; ++iD) {
               (velocityPtr + iD * numberElements)[indexLocal] += L::celerity()[iQ][iD]
-                * distributionPtr[iQ * numberElements + indexLocal];
+                * distribution_iQ;
             }
           }
 
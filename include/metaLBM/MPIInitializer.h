@@ -22,11 +22,13 @@ namespace lbm {
     static int rankBottom;
     static int rankFront;
     static int rankBack;
+    static int threadSupport;
 
     /// Launch MPI
     MPIInitializer(int argc, char** argv) {
-      int providedThreadSupport;
-      MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &providedThreadSupport);
+      MPI_Init_thread(&argc, &argv,
+                      writeAsynchronously ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED,
+                      &threadSupport);
 
       int hostNameLength;
       char hostNameChar[MPI_MAX_PROCESSOR_NAME];
@@ -75,5 +77,6 @@ namespace lbm {
   template<> int MPIInit::rankBottom = 0;
   template<> int MPIInit::rankFront = 0;
   template<> int MPIInit::rankBack = 0;
+  template<> int MPIInit::threadSupport = 0;
 
 }  // end namespace lbm
@@ -42,7 +42,37 @@ namespace lbm {
 
  enum class BoundaryType { Generic, None, Periodic, BounceBack_Halfway, Entropic };
 
+ enum class FFTWPlannerType { Estimate, Measure, Patient, Exhaustive };
+
+ enum class DerivativeType { Spectral, FiniteDifference };
+
  enum class InputOutput { Generic, None, DAT, HDF5, XDMF };
  enum class InputOutputFormat { Generic, ascii, binary };
+ enum class CompressionType { None, Deflate, ShuffleDeflate, Plugin };
+ enum class ErrorBoundType { None, Absolute, Relative };
+
+ /// Largest pointwise error allowed when quantizing an output field
+ struct ErrorBound {
+   ErrorBoundType errorBoundT;
+   double value;
+ };
+
+ enum class SubsetType { Sample, Average };
+
+ /**
+  * Box [start, end) of the global domain written every writeStep iterations,
+  * an end of 0 extending to the global length. Sample keeps every step-th
+  * node and Average the mean of each step-sized block, so a slice is a box
+  * one node thick and a region of interest a box with unit steps.
+  */
+ struct OutputSubset {
+   const char* name;
+   const char* fieldName;
+   SubsetType subsetT;
+   unsigned int writeStep;
+   unsigned int start[3];
+   unsigned int end[3];
+   unsigned int step[3];
+ };
 
 }  // namespace lbm
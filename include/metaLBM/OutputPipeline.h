@@ -0,0 +1,174 @@
+#pragma once
+
+#include <hdf5.h>
+#include <mpi.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Commons.h"
+#include "Options.h"
+
+namespace lbm {
+
+  /**
+   * Background output: writers copy their data into one of a bounded set
+   * of staging buffers and hand the actual write to a dedicated I/O
+   * thread, so time stepping resumes right after the copy. When every
+   * buffer is still being written, acquiring one blocks until the oldest
+   * write completes. Without MPI_THREAD_MULTIPLE and a thread-safe HDF5
+   * build, tasks run synchronously. HDF5 calls must then never be made
+   * concurrently from the solver thread: once a pipeline is used, every
+   * HDF5 writer has to be given it through setOutputPipeline.
+   *
+   * @tparam T datatype.
+   */
+  template <class T>
+  class OutputPipeline {
+  private:
+    const bool isAsynchronous;
+    MPI_Comm communicator;
+
+    std::vector<std::vector<T>> bufferArray;
+    std::vector<bool> isBufferFree;
+    std::deque<std::pair<unsigned int, std::function<void()>>> taskQueue;
+    unsigned int numberRunningTasks;
+    bool isStopped;
+
+    std::mutex mutex;
+    std::condition_variable taskCondition;
+    std::condition_variable bufferCondition;
+    std::thread worker;
+
+  public:
+    OutputPipeline(const unsigned int numberBuffers_in)
+      : isAsynchronous(writeAsynchronously
+                       && MPIInit::threadSupport == MPI_THREAD_MULTIPLE
+                       && getIsHDF5ThreadSafe())
+      , bufferArray(numberBuffers_in)
+      , isBufferFree(numberBuffers_in, true)
+      , numberRunningTasks(0)
+      , isStopped(false)
+    {
+      MPI_Comm_dup(MPI_COMM_WORLD, &communicator);
+
+      if (isAsynchronous) {
+        worker = std::thread(&OutputPipeline::run, this);
+      }
+      else if (writeAsynchronously && MPIInit::rank[d::X] == 0) {
+        std::cout << "MPI_THREAD_MULTIPLE or thread-safe HDF5 not provided, "
+                  << "writing synchronously\n";
+      }
+    }
+
+    ~OutputPipeline() {
+      if (isAsynchronous) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          isStopped = true;
+        }
+        taskCondition.notify_one();
+        worker.join();
+      }
+
+      MPI_Comm_free(&communicator);
+    }
+
+    inline bool getIsAsynchronous() {
+      return isAsynchronous;
+    }
+
+    /// Communicator reserved to the I/O thread, distinct from the solver's
+    inline MPI_Comm getCommunicator() {
+      return communicator;
+    }
+
+    /// Blocks until a staging buffer is free, which bounds memory use
+    inline unsigned int acquireBuffer() {
+      std::unique_lock<std::mutex> lock(mutex);
+      unsigned int iB = 0;
+
+      bufferCondition.wait(lock, [&] {
+          for (iB = 0; iB < isBufferFree.size(); ++iB) {
+            if (isBufferFree[iB]) return true;
+          }
+          return false;
+        });
+
+      isBufferFree[iB] = false;
+      return iB;
+    }
+
+    inline std::vector<T>& getBuffer(const unsigned int iB) {
+      return bufferArray[iB];
+    }
+
+    /// Runs the task on the I/O thread, then releases buffer iB
+    inline void submit(const unsigned int iB, const std::function<void()>& task) {
+      if (!isAsynchronous) {
+        task();
+        releaseBuffer(iB);
+        return;
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        taskQueue.push_back(std::make_pair(iB, task));
+      }
+      taskCondition.notify_one();
+    }
+
+    /// Waits for every submitted write to complete
+    inline void flush() {
+      std::unique_lock<std::mutex> lock(mutex);
+      bufferCondition.wait(lock, [&] {
+          return taskQueue.empty() && numberRunningTasks == 0;
+        });
+    }
+
+  private:
+    static inline bool getIsHDF5ThreadSafe() {
+      hbool_t isThreadSafe = 0;
+      H5is_library_threadsafe(&isThreadSafe);
+      return isThreadSafe;
+    }
+
+    inline void releaseBuffer(const unsigned int iB) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        isBufferFree[iB] = true;
+      }
+      bufferCondition.notify_all();
+    }
+
+    void run() {
+      while (true) {
+        std::pair<unsigned int, std::function<void()>> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          taskCondition.wait(lock, [&] { return isStopped || !taskQueue.empty(); });
+          if (taskQueue.empty()) return;
+
+          task = taskQueue.front();
+          taskQueue.pop_front();
+          ++numberRunningTasks;
+        }
+
+        task.second();
+
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          --numberRunningTasks;
+          isBufferFree[task.first] = true;
+        }
+        bufferCondition.notify_all();
+      }
+    }
+  };
+
+}  // namespace lbm
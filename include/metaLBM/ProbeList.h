@@ -0,0 +1,219 @@
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Commons.h"
+#include "Domain.h"
+#include "DynamicArray.cuh"
+#include "Lattice.h"
+#include "MathVector.h"
+#include "Options.h"
+#include "Writer.h"
+
+namespace lbm {
+
+  /**
+   * Density and velocity sampled every probeStep iterations at the
+   * numberProbes global positions of probePositions. Each rank resolves the
+   * probes it owns once, as a short list of local indices sorted in memory
+   * order; the algorithm then stores their values while computing moments.
+   * Samples stay buffered locally and are gathered on rank 0 every
+   * probeBufferSize samples to be written as one binary block.
+   *
+   * @tparam T datatype.
+   * @tparam Architecture on which the code is executed.
+   */
+  template <class T, Architecture architecture>
+  class ProbeList {
+  public:
+    static constexpr unsigned int numberValues = 1 + L::dimD;
+
+  private:
+    std::vector<Position> positions;
+    std::vector<int> localProbes;
+    DynamicArray<unsigned int, architecture> indexArray;
+    DynamicArray<T, architecture> valueArray;
+    DynamicArray<T, Architecture::CPU> hostValueArray;
+    std::vector<T> iterationArray;
+    std::vector<T> sampleArray;
+
+    std::vector<int> numberLocalProbes;
+    std::vector<int> gatheredProbes;
+    std::vector<T> gatheredArray;
+    std::vector<T> blockArray;
+    ProbeWriter<T> probeWriter;
+
+  public:
+    ProbeList(const std::string& writerFolder_in,
+              const unsigned int startIteration_in)
+      : positions(getPositions())
+      , localProbes(getLocalProbes(positions))
+      , indexArray(std::max(localProbes.size(), (size_t)1))
+      , valueArray(std::max(numberValues * localProbes.size(), (size_t)1))
+      , hostValueArray(valueArray.size())
+      , numberLocalProbes(numProcs)
+      , probeWriter(writerFolder_in, startIteration_in)
+    {
+      DynamicArray<unsigned int, Architecture::CPU> hostIndexArray(indexArray.size());
+      for (auto iL = 0; iL < localProbes.size(); ++iL) {
+        hostIndexArray[iL] = getLocalIndex(positions[localProbes[iL]]);
+      }
+      indexArray.copyFrom(hostIndexArray);
+
+      gatherLocalProbes();
+
+      if (probeStep && MPIInit::rank[d::X] == 0) {
+        std::string valueNames = "density";
+        for (auto iD = 0; iD < L::dimD; ++iD) {
+          valueNames += std::string(" velocity") + dName[iD];
+        }
+        probeWriter.writeHeader(positions, valueNames);
+      }
+    }
+
+    inline bool getIsProbed(const unsigned int iteration) {
+      return probeStep && (iteration % probeStep) == 0;
+    }
+
+    inline unsigned int* getIndexPtr() {
+      return indexArray.data();
+    }
+
+    inline unsigned int getNumberLocalProbes() {
+      return localProbes.size();
+    }
+
+    inline T* getValuePtr() {
+      return valueArray.data();
+    }
+
+    /// Appends the values stored by the algorithm at this iteration
+    inline void record(const unsigned int iteration) {
+      LBM_INSTRUMENT_ON("ProbeList::record", 3)
+
+      valueArray.copyTo(hostValueArray);
+      iterationArray.push_back(iteration);
+      sampleArray.insert(sampleArray.end(), hostValueArray.data(),
+                         hostValueArray.data() + numberValues * localProbes.size());
+
+      if (iterationArray.size() >= probeBufferSize) {
+        flush();
+      }
+    }
+
+    /// Gathers the buffered samples on rank 0 and writes them in global order
+    void flush() {
+      LBM_INSTRUMENT_ON("ProbeList::flush", 3)
+
+      const unsigned int numberSamples = iterationArray.size();
+      if (numberSamples == 0) return;
+
+      std::vector<int> counts(numProcs);
+      std::vector<int> displacements(numProcs);
+      for (auto iR = 0, displacement = 0; iR < numProcs; ++iR) {
+        counts[iR] = numberSamples * numberValues * numberLocalProbes[iR];
+        displacements[iR] = displacement;
+        displacement += counts[iR];
+      }
+
+      gatheredArray.resize(numberSamples * numberValues * positions.size());
+      MPI_Gatherv(sampleArray.data(), sampleArray.size(), MPI_DOUBLE,
+                  gatheredArray.data(), counts.data(), displacements.data(),
+                  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+      if (MPIInit::rank[d::X] == 0) {
+        const unsigned int recordSize = 1 + numberValues * positions.size();
+        blockArray.resize(numberSamples * recordSize);
+
+        for (auto iS = 0; iS < numberSamples; ++iS) {
+          blockArray[iS * recordSize] = iterationArray[iS];
+        }
+
+        for (auto iR = 0, iG = 0; iR < numProcs; ++iR) {
+          for (auto iS = 0; iS < numberSamples; ++iS) {
+            for (auto iL = 0; iL < numberLocalProbes[iR]; ++iL) {
+              const unsigned int iProbe = gatheredProbes[iG + iL];
+              for (auto iV = 0; iV < numberValues; ++iV) {
+                blockArray[iS * recordSize + 1 + iProbe * numberValues + iV] =
+                  gatheredArray[displacements[iR]
+                                + (iS * numberLocalProbes[iR] + iL) * numberValues + iV];
+              }
+            }
+          }
+          iG += numberLocalProbes[iR];
+        }
+
+        probeWriter.writeBlock(blockArray.data(), blockArray.size());
+      }
+
+      iterationArray.clear();
+      sampleArray.clear();
+    }
+
+  private:
+    /// Positions are wrapped into the periodic domain
+    static inline std::vector<Position> getPositions() {
+      std::vector<Position> positionsR;
+      if (!probeStep) return positionsR;
+
+      for (auto iProbe = 0; iProbe < numberProbes; ++iProbe) {
+        Position position = {{0, 0, 0}};
+        for (auto iD = 0; iD < L::dimD; ++iD) {
+          position[iD] = probePositions[iProbe][iD] % gSD::sLength()[iD];
+        }
+        positionsR.push_back(position);
+      }
+
+      return positionsR;
+    }
+
+    static inline unsigned int getLocalIndex(const Position& position) {
+      return lSD::getIndex(position - gSD::sOffset(MPIInit::rank));
+    }
+
+    /// Owned probes, sorted by local index so the algorithm can search them
+    static inline std::vector<int> getLocalProbes(const std::vector<Position>& positions) {
+      const Position offset = gSD::sOffset(MPIInit::rank);
+      std::vector<int> localProbesR;
+
+      for (auto iProbe = 0; iProbe < positions.size(); ++iProbe) {
+        bool isLocal = true;
+        for (auto iD = 0; iD < L::dimD; ++iD) {
+          isLocal = isLocal && positions[iProbe][iD] >= offset[iD]
+            && positions[iProbe][iD] < offset[iD] + lSD::sLength()[iD];
+        }
+        if (isLocal) localProbesR.push_back(iProbe);
+      }
+
+      std::stable_sort(localProbesR.begin(), localProbesR.end(),
+                       [&](const int iLeft, const int iRight) {
+                         return getLocalIndex(positions[iLeft])
+                           < getLocalIndex(positions[iRight]);
+                       });
+
+      return localProbesR;
+    }
+
+    /// Rank 0 learns once which probes every rank owns
+    inline void gatherLocalProbes() {
+      const int numberLocal = localProbes.size();
+      MPI_Gather(&numberLocal, 1, MPI_INT, numberLocalProbes.data(), 1, MPI_INT,
+                 0, MPI_COMM_WORLD);
+
+      std::vector<int> displacements(numProcs);
+      for (auto iR = 0, displacement = 0; iR < numProcs; ++iR) {
+        displacements[iR] = displacement;
+        displacement += numberLocalProbes[iR];
+      }
+
+      gatheredProbes.resize(positions.size());
+      MPI_Gatherv(localProbes.data(), numberLocal, MPI_INT, gatheredProbes.data(),
+                  numberLocalProbes.data(), displacements.data(), MPI_INT, 0,
+                  MPI_COMM_WORLD);
+    }
+  };
+
+}  // namespace lbm
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "Commons.h"
 #include "Domain.h"
@@ -22,8 +24,9 @@ class FieldReader<T, InputOutput::HDF5>
 
  public:
   FieldReader(const std::string& filePrefix_in,
-              const std::string& name_in = "field")
-      : Base(filePrefix_in, name_in) {}
+              const std::string& name_in = "field",
+              const bool isPadded_in = true)
+      : Base(filePrefix_in, name_in, false, isPadded_in) {}
 
   inline void openFile(const unsigned int iteration) {
     std::string fileName = Base::getFileName(iteration);
@@ -34,8 +37,9 @@ class FieldReader<T, InputOutput::HDF5>
 
   inline void closeFile() { Base::statusHDF5 = H5Fclose(Base::fileHDF5); }
 
-  template <unsigned int NumberComponents, Architecture architecture>
-  void readField(Field<T, NumberComponents, architecture, true>& field) {
+  template <unsigned int NumberComponents, Architecture architecture,
+            bool IsTransformed>
+  void readField(Field<T, NumberComponents, architecture, true, IsTransformed>& field) {
     LBM_INSTRUMENT_ON("Reader<HDF5>::readField<NumberComponents>", 3)
 
     std::string fieldName = field.fieldName;
@@ -76,7 +80,8 @@ class FieldReader<T, InputOutput::HDF5>
 
       Base::statusHDF5 = H5Dread(
           Base::dataSetHDF5, H5T_NATIVE_DOUBLE, Base::dataSpaceHDF5,
-          Base::fileSpaceHDF5, Base::propertyListHDF5, field.getData(iC));
+          Base::fileSpaceHDF5, Base::propertyListHDF5,
+          field.getData(field.getNumberElements(), iC));
 
       Base::statusHDF5 = H5Dclose(Base::dataSetHDF5);
       Base::statusHDF5 = H5Sclose(Base::dataSpaceHDF5);
@@ -86,8 +91,9 @@ class FieldReader<T, InputOutput::HDF5>
     Base::statusHDF5 = H5Pclose(Base::propertyListHDF5);
   }
 
-  template <unsigned int NumberComponents, Architecture architecture>
-  void readField(Field<T, NumberComponents, architecture, false>& field) {}
+  template <unsigned int NumberComponents, Architecture architecture,
+            bool IsTransformed>
+  void readField(Field<T, NumberComponents, architecture, false, IsTransformed>& field) {}
 
   inline void open(const std::string& fileName) {
     Base::propertyListHDF5 = H5Pcreate(H5P_FILE_ACCESS);
@@ -114,39 +120,81 @@ class DistributionReader<T, InputOutput::HDF5>
 
  public:
   DistributionReader(const std::string& filePrefix_in)
-      : Base(filePrefix_in, "distribution") {}
+      : Base(filePrefix_in, "distribution", false) {}
 
+  /// Aborts when the checkpoint cannot be read into the current domain
+  inline void openFile(const unsigned int iteration) {
+    Base::openFile(iteration);
+
+    const std::map<std::string, std::vector<int>> attributes =
+        DistributionWriter<T, InputOutput::HDF5>::getCheckpointAttributes();
+    std::map<std::string, std::vector<int>> fileAttributes;
+    for (auto iA = attributes.begin(); iA != attributes.end(); ++iA) {
+      if (!readFileAttribute(iA->first, fileAttributes[iA->first])) {
+        if (MPIInit::rank[d::X] == 0) {
+          std::cout << "Checkpoint has no " << iA->first
+                    << " attribute, assuming it matches" << std::endl;
+        }
+        fileAttributes[iA->first] = iA->second;
+      }
+    }
+
+    if (fileAttributes["global_length"] != attributes.at("global_length")
+        || fileAttributes["lattice"] != attributes.at("lattice")) {
+      if (MPIInit::rank[d::X] == 0) {
+        std::cout << "Checkpoint global lengths or lattice don't match"
+                  << std::endl;
+      }
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    const std::vector<int>& decomposition = fileAttributes["decomposition"];
+    if (decomposition != attributes.at("decomposition")
+        && decomposition.size() == 2 && MPIInit::rank[d::X] == 0) {
+      std::cout << "Repartitioning checkpoint written by " << decomposition[1]
+                << " processes onto " << numProcs << std::endl;
+    }
+  }
+
+  /// Reads this rank's block of the global populations in place, whatever
+  /// the number of processes that wrote them
   template <Architecture architecture>
-  void readDistribution(Distribution<T, architecture>& distribution) {
-    LBM_INSTRUMENT_ON("Reader<HDF5>::readField<NumberComponents>", 3)
+  void readDistribution(Distribution<T, architecture>& distribution,
+                        T* haloDistributionPtr,
+                        const Stream<architecture>& stream) {
+    LBM_INSTRUMENT_ON("Reader<HDF5>::readDistribution", 3)
 
     Base::propertyListHDF5 = H5Pcreate(H5P_DATASET_XFER);
 
-    for (auto iC = 0; iC < L::dimQ; ++iC) {
+    for (auto iQ = 0; iQ < L::dimQ; ++iQ) {
       Base::dataSetHDF5 = H5Dopen2(Base::fileHDF5,
-                                   (distribution.fieldName + std::to_string(iC)).c_str(),
+                                   (distribution.fieldName + std::to_string(iQ)).c_str(),
                                    H5P_DEFAULT);
 
-      Base::fileSpaceHDF5 = H5Screate_simple(
-          L::dimD,
-          Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(),
-          NULL);
+      Base::dataSpaceHDF5 = architecture == Architecture::CPU
+        ? DistributionWriter<T, InputOutput::HDF5>::getHaloSpace(iQ)
+        : DistributionWriter<T, InputOutput::HDF5>::getPaddedSpace();
+      T* dataPtr = architecture == Architecture::CPU
+        ? haloDistributionPtr : distribution.getStagingData();
 
-      Base::dataSpaceHDF5 = H5Dget_space(Base::dataSetHDF5);
+      Base::fileSpaceHDF5 = H5Dget_space(Base::dataSetHDF5);
 
       H5Sselect_hyperslab(
-          Base::dataSpaceHDF5, H5S_SELECT_SET,
-          Project<hsize_t, unsigned int, L::dimD>::Do(gSD::pOffset(MPIInit::rank)).data(),
+          Base::fileSpaceHDF5, H5S_SELECT_SET,
+          Project<hsize_t, unsigned int, L::dimD>::Do(gSD::sOffset(MPIInit::rank)).data(),
           NULL,
-          Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(),
+          Project<hsize_t, unsigned int, L::dimD>::Do(lSD::sLength()).data(),
           NULL);
 
       H5Pset_dxpl_mpio(Base::propertyListHDF5, H5FD_MPIO_COLLECTIVE);
 
       Base::statusHDF5 =
-          H5Dread(Base::dataSetHDF5, H5T_NATIVE_DOUBLE, Base::fileSpaceHDF5,
-                  Base::dataSpaceHDF5, Base::propertyListHDF5,
-                  distribution.getData(FFTWInit::numberElements, iC));
+          H5Dread(Base::dataSetHDF5, H5T_NATIVE_DOUBLE, Base::dataSpaceHDF5,
+                  Base::fileSpaceHDF5, Base::propertyListHDF5, dataPtr);
+
+      if (architecture != Architecture::CPU) {
+        distribution.unstagePopulation(stream, haloDistributionPtr, iQ);
+      }
 
       Base::statusHDF5 = H5Dclose(Base::dataSetHDF5);
       Base::statusHDF5 = H5Sclose(Base::dataSpaceHDF5);
@@ -157,7 +205,23 @@ class DistributionReader<T, InputOutput::HDF5>
   }
 
   using Base::closeFile;
-  using Base::openFile;
+
+ private:
+  /// Integer array attribute of the file root, false if absent
+  inline bool readFileAttribute(const std::string& name,
+                                std::vector<int>& values) {
+    if (H5Aexists(Base::fileHDF5, name.c_str()) <= 0) return false;
+
+    const hid_t attributeHDF5 = H5Aopen(Base::fileHDF5, name.c_str(), H5P_DEFAULT);
+    const hid_t attributeSpaceHDF5 = H5Aget_space(attributeHDF5);
+
+    values.assign(H5Sget_simple_extent_npoints(attributeSpaceHDF5), 0);
+    Base::statusHDF5 = H5Aread(attributeHDF5, H5T_NATIVE_INT, values.data());
+
+    Base::statusHDF5 = H5Sclose(attributeSpaceHDF5);
+    Base::statusHDF5 = H5Aclose(attributeHDF5);
+    return true;
+  }
 };
 
 typedef FieldReader<dataT, InputOutput::HDF5> FieldReader_;
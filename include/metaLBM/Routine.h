@@ -4,16 +4,20 @@
 
 #include "Algorithm.h"
 #include "AnalysisList.h"
+#include "BuddyCheckpoint.h"
 #include "Commons.h"
 #include "Communication.h"
 #include "Computation.h"
 #include "Event.h"
 #include "Distribution.h"
 #include "FieldList.h"
+#include "FiniteDifference.h"
 #include "FourierDomain.h"
 #include "Lattice.h"
 #include "MathVector.h"
 #include "Options.h"
+#include "ProbeList.h"
+#include "Statistics.h"
 #include "Transformer.h"
 #include "Writer.h"
 
@@ -43,13 +47,21 @@ namespace lbm {
 
     FieldWriter_ fieldWriter;
     DistributionWriter_ distributionWriter;
+    BuddyCheckpoint<T, architecture> buddyCheckpoint;
+    SubsetWriter_ subsetWriter;
+    OutputPipeline<T> outputPipeline;
     FieldList<T, architecture> fieldList;
     Distribution<T, architecture> distribution;
 
     Curl<double, Architecture::CPU, PartitionningType::OneD, L::dimD, L::dimD>
     curlVelocity;
+    FiniteDifferenceCurl<T, L::dimD> finiteDifferenceCurlVelocity;
+    int vorticityIteration;
+    bool isVorticitySpectral;
     ScalarAnalysisList<T, architecture> scalarAnalysisList;
     SpectralAnalysisList<T, architecture> spectralAnalysisList;
+    ProbeList<T, architecture> probeList;
+    StatisticsList<T, architecture> statisticsList;
 
     Algorithm_ algorithm;
     PerformanceAnalysisList performanceAnalysisList;
@@ -65,11 +77,18 @@ namespace lbm {
       , rightEvent()
       , fieldWriter(prefix)
       , distributionWriter(prefix)
+      , buddyCheckpoint()
+      , subsetWriter(prefix)
+      , outputPipeline(numberOutputBuffers)
       , fieldList(fieldWriter, defaultStream)
       , curlVelocity(fieldList.velocity.getData(FFTWInit::numberElements),
                      fieldList.vorticity.getData(FFTWInit::numberElements),
                      Cast<unsigned int, ptrdiff_t, 3>::Do(gSD::sLength()).data(),
                      gFD::offset(MPIInit::rank))
+      , finiteDifferenceCurlVelocity(fieldList.velocity.getData(FFTWInit::numberElements),
+                                     fieldList.vorticity.getData(FFTWInit::numberElements))
+      , vorticityIteration(-1)
+      , isVorticitySpectral(false)
       , distribution(initDistribution<T, architecture>(fieldList.density,
                                                        fieldList.velocity,
                                                        defaultStream))
@@ -77,9 +96,23 @@ namespace lbm {
                            startIteration)
       , spectralAnalysisList(fieldList, communication, spectralAnalysisStep,
                              startIteration)
+      , probeList(prefix, startIteration)
+      , statisticsList(prefix, fieldList.velocity.getData(FFTWInit::numberElements),
+                       FFTWInit::numberElements)
       , algorithm(fieldList, distribution, communication)
       , performanceAnalysisList(performanceAnalysisStep, startIteration)
     {
+      if (outputPipeline.getIsAsynchronous()) {
+        fieldWriter.setOutputPipeline(&outputPipeline);
+        distributionWriter.setOutputPipeline(&outputPipeline);
+        subsetWriter.setOutputPipeline(&outputPipeline);
+        statisticsList.setOutputPipeline(&outputPipeline);
+      }
+
+      algorithm.scalarSumPtr = scalarAnalysisList.getPartialSumPtr();
+      algorithm.probeIndexPtr = probeList.getIndexPtr();
+      algorithm.numberLocalProbes = probeList.getNumberLocalProbes();
+      algorithm.probeValuePtr = probeList.getValuePtr();
       printInputs();
     }
 
@@ -90,14 +123,15 @@ namespace lbm {
     void compute() {
       LBM_INSTRUMENT_ON("Routine<T>::compute", 1)
 
-        algorithm.unpack(defaultStream);
-
       Clock::time_point t0;
       Clock::time_point t1;
 
-      if (writeFieldInit || writeAnalysisInit) {
-        curlVelocity.executeSpace();
-        curlVelocity.normalize();
+      const bool isVorticitySubsetInit = writeFieldInit
+        && subsetWriter.getIsWritten(startIteration, "vorticity");
+      if (getIsVorticityNeeded(writeFieldInit, isVorticitySubsetInit,
+                               writeAnalysisInit)) {
+        computeVorticity(startIteration,
+                         getIsVorticitySpectral(writeFieldInit, isVorticitySubsetInit));
       }
 
       if (writeFieldInit) {
@@ -115,20 +149,39 @@ namespace lbm {
       }
 
       performanceAnalysisList.setInitialMass(
-                                             communication.reduce(fieldList.density.getData(FFTWInit::numberElements)));
+                                             communication.reduce(fieldList.density.getData(lSD::pVolume())));
 
       // Execute LBM algorithm
       for (int iteration = startIteration + 1; iteration <= endIteration; ++iteration) {
         algorithm.isStored = (fieldWriter.getIsWritten(iteration)
+                              || subsetWriter.getIsWritten(iteration)
                               || scalarAnalysisList.getIsAnalyzed(iteration)
-                              || spectralAnalysisList.getIsAnalyzed(iteration));
+                              || spectralAnalysisList.getIsAnalyzed(iteration)
+                              || statisticsList.getIsSampled(iteration));
+        algorithm.isAnalyzed = (architecture == Architecture::CPU
+                                && scalarAnalysisList.getIsAnalyzed(iteration));
+        algorithm.isProbed = probeList.getIsProbed(iteration);
 
         algorithm.iterate(iteration, defaultStream, bulkStream, leftStream, rightStream,
                           leftEvent, rightEvent);
 
-        if (algorithm.isStored) {
-          curlVelocity.executeSpace();
-          curlVelocity.normalize();
+        if (algorithm.isProbed) {
+          probeList.record(iteration);
+        }
+
+        if (statisticsList.getIsSampled(iteration)) {
+          t0 = Clock::now();
+          statisticsList.accumulate(iteration);
+          t1 = Clock::now();
+          performanceAnalysisList.updateWriteAnalysisTime(Seconds(t1 - t0).count());
+        }
+
+        const bool isFieldWritten = fieldWriter.getIsWritten(iteration);
+        const bool isVorticitySubset = subsetWriter.getIsWritten(iteration, "vorticity");
+        if (getIsVorticityNeeded(isFieldWritten, isVorticitySubset,
+                                 scalarAnalysisList.getIsAnalyzed(iteration))) {
+          computeVorticity(iteration,
+                           getIsVorticitySpectral(isFieldWritten, isVorticitySubset));
         }
 
         t0 = Clock::now();
@@ -146,8 +199,23 @@ namespace lbm {
 
       }
 
+      t0 = Clock::now();
+      statisticsList.writeStatistics(endIteration);
+      t1 = Clock::now();
+      performanceAnalysisList.updateWriteFieldTime(Seconds(t1 - t0).count());
+
+      t0 = Clock::now();
+      probeList.flush();
+      t1 = Clock::now();
+      performanceAnalysisList.updateWriteAnalysisTime(Seconds(t1 - t0).count());
+
+      t0 = Clock::now();
+      outputPipeline.flush();
+      t1 = Clock::now();
+      performanceAnalysisList.updateWriteFieldTime(Seconds(t1 - t0).count());
+
       performanceAnalysisList.updateMass(communication.reduce(
-                                                              fieldList.density.getData(FFTWInit::numberElements)));
+                                                              fieldList.density.getData(lSD::pVolume())));
 
       performanceAnalysisList.updateMLUPS(endIteration - startIteration);
 
@@ -199,6 +267,37 @@ namespace lbm {
       }
     }
 
+    /// Vorticity is consumed by its field output, the output subsets naming
+    /// it and the enstrophy analysis
+    bool getIsVorticityNeeded(const bool isFieldWritten, const bool isSubsetWritten,
+                              const bool isScalarAnalyzed) {
+      return (writeVorticity && isFieldWritten) || isSubsetWritten
+        || (analyzeTotalEnstrophy && isScalarAnalyzed);
+    }
+
+    /// Written vorticity keeps the spectral curl, enstrophy alone may use a stencil
+    bool getIsVorticitySpectral(const bool isFieldWritten, const bool isSubsetWritten) {
+      return (writeVorticity && isFieldWritten) || isSubsetWritten
+        || enstrophyDerivativeT == DerivativeType::Spectral;
+    }
+
+    /// Curl of the velocity, computed at most once per iteration
+    void computeVorticity(const int iteration, const bool isSpectral) {
+      if (iteration == vorticityIteration
+          && (isVorticitySpectral || !isSpectral)) return;
+
+      if (isSpectral) {
+        curlVelocity.executeSpace();
+        curlVelocity.normalize();
+      }
+      else {
+        finiteDifferenceCurlVelocity.execute(FFTWInit::numberElements);
+      }
+
+      vorticityIteration = iteration;
+      isVorticitySpectral = isSpectral;
+    }
+
     void writeFields(const unsigned int iteration) {
       LBM_INSTRUMENT_ON("Routine<T>::writeFields", 2)
 
@@ -210,10 +309,24 @@ namespace lbm {
         }
 
       if (distributionWriter.getIsBackedUp(iteration)) {
-        algorithm.pack(defaultStream);
         distributionWriter.openFile(iteration);
-        distributionWriter.writeDistribution(distribution);
+        distributionWriter.writeDistribution(distribution,
+                                             algorithm.getHaloDistributionNextPtr(),
+                                             defaultStream);
         distributionWriter.closeFile();
+
+        statisticsList.writeStatistics(iteration);
+      }
+
+      if (subsetWriter.getIsWritten(iteration)) {
+        subsetWriter.openFile(iteration);
+        fieldList.writeSubsets(subsetWriter);
+        subsetWriter.closeFile();
+      }
+
+      if (buddyCheckpoint.getIsBackedUp(iteration)) {
+        buddyCheckpoint.save(iteration, distribution,
+                             algorithm.getHaloDistributionNextPtr(), defaultStream);
       }
     }
 
@@ -221,6 +334,7 @@ namespace lbm {
       LBM_INSTRUMENT_ON("Routine<T>::writeFields", 2)
 
         if (scalarAnalysisList.getIsAnalyzed(iteration)) {
+          if (!algorithm.isAnalyzed) scalarAnalysisList.accumulatePartialSums();
           scalarAnalysisList.writeAnalyses(iteration);
         }
 
@@ -230,7 +344,7 @@ namespace lbm {
 
       if (performanceAnalysisList.getIsAnalyzed(iteration)) {
         performanceAnalysisList.updateMass(communication.reduce(
-                                                                fieldList.density.getData(FFTWInit::numberElements)));
+                                                                fieldList.density.getData(lSD::pVolume())));
 
         performanceAnalysisList.updateMLUPS(iteration - startIteration);
 
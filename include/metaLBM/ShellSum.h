@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "Commons.h"
+#include "Computation.h"
+#include "Domain.h"
+#include "MathVector.h"
+
+namespace lbm {
+
+  /**
+   * Physical-space synthesis of a field holding only the modes of a
+   * wavenumber shell, evaluated as a direct sum instead of a backward FFT.
+   * Modes are those of the r2c half-space (last wavenumber >= 0) and
+   * coefficients follow the unnormalized FFTW convention, so the result
+   * matches BackwardFFT. exp(i k.x) factorizes per axis and is read from
+   * per-axis twiddle tables over the local positions.
+   *
+   * @tparam NumberComponents number of components of the synthesized field.
+   */
+  template <unsigned int NumberComponents>
+  class ShellSum {
+  private:
+    const int kMax;
+    const Position offset;
+    std::vector<WaveNumber> waveNumbers;
+    std::vector<double> weights;
+    std::vector<double> coefficientArray;
+    std::vector<double> twiddleArray[3];
+    Computation<Architecture::CPU, L::dimD> computationLocal;
+
+  public:
+    ShellSum(const unsigned int kMin_in, const unsigned int kMax_in,
+             const Position& offset_in)
+      : kMax(kMax_in)
+      , offset(offset_in)
+      , computationLocal(lSD::sStart(), lSD::sEnd())
+    {
+      initWaveNumbers(kMin_in);
+      coefficientArray.assign(2 * NumberComponents * size(), 0.0);
+      if (size() > 0) initTwiddleArrays();
+    }
+
+    inline unsigned int size() const {
+      return waveNumbers.size();
+    }
+
+    inline const WaveNumber& getWaveNumber(const unsigned int iM) const {
+      return waveNumbers[iM];
+    }
+
+    /// Sets the Fourier coefficient of component iC for mode iM
+    inline void setCoefficient(const unsigned int iM, const unsigned int iC,
+                               const double real, const double imaginary) {
+      coefficientArray[2 * (NumberComponents * iM + iC) + p::Re] = real;
+      coefficientArray[2 * (NumberComponents * iM + iC) + p::Im] = imaginary;
+    }
+
+    /// Writes the synthesized field with a stride of numberElements
+    LBM_HOST
+    inline void execute(double* spacePtr, const unsigned int numberElements) {
+      const double* coefficientPtr = coefficientArray.data();
+
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
+          const auto index = lSD::getIndex(iP);
+          double value[NumberComponents] = {0};
+
+          for (auto iM = 0; iM < size(); ++iM) {
+            double phaseRe = 1.0;
+            double phaseIm = 0.0;
+            for (auto iD = 0; iD < L::dimD; ++iD) {
+              const double* twiddlePtr = twiddleArray[iD].data()
+                + 2 * ((waveNumbers[iM][iD] + kMax) * lSD::sLength()[iD] + iP[iD]);
+              const double product = phaseRe * twiddlePtr[p::Re]
+                - phaseIm * twiddlePtr[p::Im];
+              phaseIm = phaseRe * twiddlePtr[p::Im] + phaseIm * twiddlePtr[p::Re];
+              phaseRe = product;
+            }
+
+            for (auto iC = 0; iC < NumberComponents; ++iC) {
+              const double* modePtr =
+                coefficientPtr + 2 * (NumberComponents * iM + iC);
+              value[iC] += weights[iM] *
+                (modePtr[p::Re] * phaseRe - modePtr[p::Im] * phaseIm);
+            }
+          }
+
+          for (auto iC = 0; iC < NumberComponents; ++iC) {
+            (spacePtr + iC * numberElements)[index] = value[iC];
+          }
+      });
+      computationLocal.synchronize();
+    }
+
+    /// Rough flop balance between the direct sum and a backward FFT per cell
+    static inline bool getIsCheaperThanFFT(const unsigned int numberModes) {
+      return numberModes < 2 * std::log2((double)gSD::sVolume());
+    }
+
+    /// Number of modes of the shell, without building any table
+    static inline unsigned int getNumberModes(const unsigned int kMin,
+                                              const int kMax) {
+      unsigned int numberModesR = 0;
+      for (int kX = -kMax; kX <= kMax; ++kX) {
+        for (int kY = (L::dimD > 1 ? -kMax : 0); kY <= (L::dimD > 1 ? kMax : 0); ++kY) {
+          for (int kZ = (L::dimD > 2 ? -kMax : 0); kZ <= (L::dimD > 2 ? kMax : 0); ++kZ) {
+            if (getIsInShell(WaveNumber{{kX, kY, kZ}}, kMin, kMax)) ++numberModesR;
+          }
+        }
+      }
+
+      return numberModesR;
+    }
+
+  private:
+    /// Both k and -k are kept when the last wavenumber is 0, else only k
+    static inline bool getIsInShell(const WaveNumber& iK, const unsigned int kMin,
+                                    const int kMax) {
+      const unsigned int kNormSquared = iK.norm2();
+      return iK[L::dimD - 1] >= 0 && kNormSquared >= kMin * kMin
+        && kNormSquared <= kMax * kMax;
+    }
+
+    inline void initWaveNumbers(const unsigned int kMin) {
+      for (int kX = -kMax; kX <= kMax; ++kX) {
+        for (int kY = (L::dimD > 1 ? -kMax : 0); kY <= (L::dimD > 1 ? kMax : 0); ++kY) {
+          for (int kZ = (L::dimD > 2 ? -kMax : 0); kZ <= (L::dimD > 2 ? kMax : 0); ++kZ) {
+            WaveNumber iK{{kX, kY, kZ}};
+            if (!getIsInShell(iK, kMin, kMax)) continue;
+
+            waveNumbers.push_back(iK);
+            weights.push_back((iK[L::dimD - 1] == 0 ? 1.0 : 2.0) / gSD::sVolume());
+          }
+        }
+      }
+    }
+
+    inline void initTwiddleArrays() {
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        const unsigned int localLength = lSD::sLength()[iD];
+        twiddleArray[iD].resize(2 * (2 * kMax + 1) * localLength);
+
+        for (int k = -kMax; k <= kMax; ++k) {
+          for (auto i = 0; i < localLength; ++i) {
+            const double angle =
+              2 * M_PI * k * (double)(i + offset[iD]) / gSD::sLength()[iD];
+            twiddleArray[iD][2 * ((k + kMax) * localLength + i) + p::Re] = cos(angle);
+            twiddleArray[iD][2 * ((k + kMax) * localLength + i) + p::Im] = sin(angle);
+          }
+        }
+      }
+    }
+  };
+
+}  // namespace lbm
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+
+#include "Commons.h"
+#include "Computation.h"
+#include "Domain.h"
+#include "Field.h"
+#include "FiniteDifference.h"
+#include "Lattice.h"
+#include "Options.h"
+#include "OutputPipeline.h"
+#include "Writer.h"
+
+namespace lbm {
+
+  /**
+   * Running time statistics accumulated in situ every statisticsStep
+   * iterations: mean velocity, Reynolds stresses and mean dissipation.
+   * Means and covariances are updated with Welford's recurrence, so they
+   * hold current values after every sample and never subtract large
+   * accumulated sums. Reynolds stresses are split into diagonal and
+   * off-diagonal components ordered as pi1. Dissipation 2 nu S_ij S_ij
+   * is computed in lattice units from fourth-order velocity gradients.
+   *
+   * @tparam T datatype.
+   * @tparam Architecture on which the code is executed.
+   */
+  template <class T, Architecture architecture>
+  class StatisticsList : public FiniteDifference<T, L::dimD> {
+  private:
+    using Base = FiniteDifference<T, L::dimD>;
+    static constexpr bool IsAccumulated = statisticsStep > 0;
+
+    const unsigned int numberElements;
+    unsigned int numberSamples;
+    unsigned int firstIteration;
+    unsigned int lastIteration;
+    unsigned int writtenIteration;
+    Computation<Architecture::CPU, L::dimD> computationLocal;
+    FieldWriter_ statisticsWriter;
+
+  public:
+    Field<T, L::dimD, Architecture::CPU, IsAccumulated> meanVelocity;
+    Field<T, L::dimD, Architecture::CPU, IsAccumulated> reynoldsStressDiagonal;
+    Field<T, 2 * L::dimD - 3, Architecture::CPU, IsAccumulated>
+    reynoldsStressSymmetric;
+    Field<T, 1, Architecture::CPU, IsAccumulated> meanDissipation;
+
+    StatisticsList(const std::string& filePrefix_in, const T* velocityPtr_in,
+                   const unsigned int numberElements_in)
+      : Base(velocityPtr_in)
+      , numberElements(numberElements_in)
+      , numberSamples(0)
+      , firstIteration(0)
+      , lastIteration(0)
+      , writtenIteration(0)
+      , computationLocal(lSD::sStart(), lSD::sEnd())
+      , statisticsWriter(filePrefix_in, "statistics", false)
+      , meanVelocity("mean_velocity")
+      , reynoldsStressDiagonal("reynolds_stress_diagonal")
+      , reynoldsStressSymmetric("reynolds_stress_symmetric")
+      , meanDissipation("mean_dissipation")
+    {
+      reset(meanVelocity);
+      reset(reynoldsStressDiagonal);
+      reset(reynoldsStressSymmetric);
+      reset(meanDissipation);
+    }
+
+    /// Statistics files are then written by the I/O thread
+    inline void setOutputPipeline(OutputPipeline<T>* outputPipelinePtr_in) {
+      statisticsWriter.setOutputPipeline(outputPipelinePtr_in);
+    }
+
+    inline bool getIsSampled(const unsigned int iteration) {
+      return statisticsStep && (iteration % statisticsStep) == 0;
+    }
+
+    /// Velocity must have been stored by the algorithm at this iteration,
+    /// before any checkpoint of the same iteration is written
+    LBM_HOST
+    void accumulate(const unsigned int iteration) {
+      LBM_INSTRUMENT_ON("StatisticsList<T>::accumulate", 2)
+
+      if (numberSamples == 0) firstIteration = iteration;
+      ++numberSamples;
+      lastIteration = iteration;
+
+      Base::exchangeHalo(numberElements);
+
+      const T inverseSamples = (T)1 / numberSamples;
+      const T viscosity = L::cs2 * (relaxationTime - 0.5);
+      T* meanVelocityPtr = meanVelocity.getData(lSD::pVolume());
+      T* stressDiagonalPtr = reynoldsStressDiagonal.getData(lSD::pVolume());
+      T* stressSymmetricPtr = reynoldsStressSymmetric.getData(lSD::pVolume());
+      T* meanDissipationPtr = meanDissipation.getData(lSD::pVolume());
+
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
+          const auto index = lSD::getIndex(iP);
+
+          T deltaOld[L::dimD];
+          T deltaNew[L::dimD];
+          for (auto iD = 0; iD < L::dimD; ++iD) {
+            T& mean = (meanVelocityPtr + iD * lSD::pVolume())[index];
+            const T velocity =
+              (Base::spaceInPtr + iD * numberElements)[index];
+
+            deltaOld[iD] = velocity - mean;
+            mean += deltaOld[iD] * inverseSamples;
+            deltaNew[iD] = velocity - mean;
+          }
+
+          for (auto iD = 0; iD < L::dimD; ++iD) {
+            T& stress = (stressDiagonalPtr + iD * lSD::pVolume())[index];
+            stress += (deltaOld[iD] * deltaNew[iD] - stress) * inverseSamples;
+          }
+
+          for (auto iD = 0; iD < 2 * L::dimD - 3; ++iD) {
+            const auto iD1 = iD == 0 ? d::X : iD - 1;
+            const auto iD2 = iD == 0 ? d::Y : d::Z;
+            T& stress = (stressSymmetricPtr + iD * lSD::pVolume())[index];
+            stress += (deltaOld[iD1] * deltaNew[iD2] - stress) * inverseSamples;
+          }
+
+          T gradient[L::dimD][L::dimD];
+          for (auto iD = 0; iD < L::dimD; ++iD) {
+            for (auto iC = 0; iC < L::dimD; ++iC) {
+              gradient[iD][iC] = Base::derivative(iP, iD, iC, numberElements)
+                / Base::scale[iD];
+            }
+          }
+
+          T strainSquared = 0;
+          for (auto iD = 0; iD < L::dimD; ++iD) {
+            for (auto iC = 0; iC < L::dimD; ++iC) {
+              const T strain = (gradient[iD][iC] + gradient[iC][iD]) / 2;
+              strainSquared += strain * strain;
+            }
+          }
+
+          T& dissipation = meanDissipationPtr[index];
+          dissipation += (2 * viscosity * strainSquared - dissipation)
+            * inverseSamples;
+      });
+      computationLocal.synchronize();
+    }
+
+    /// Sample count and window are stored so that runs can be merged offline
+    void writeStatistics(const unsigned int iteration) {
+      LBM_INSTRUMENT_ON("StatisticsList<T>::writeStatistics", 2)
+
+      if (numberSamples == 0 || iteration == writtenIteration) return;
+
+      statisticsWriter.setFileAttribute("number_samples", {(int)numberSamples});
+      statisticsWriter.setFileAttribute("sampled_iterations",
+                                        {(int)firstIteration, (int)lastIteration,
+                                         (int)statisticsStep});
+
+      statisticsWriter.openFile(iteration);
+      statisticsWriter.writeField(meanVelocity);
+      statisticsWriter.writeField(reynoldsStressDiagonal);
+      statisticsWriter.writeField(reynoldsStressSymmetric);
+      statisticsWriter.writeField(meanDissipation);
+      statisticsWriter.closeFile();
+
+      writtenIteration = iteration;
+    }
+
+  private:
+    /// Padding is zeroed too, as it is written with the local block
+    template <unsigned int NumberComponents>
+    static inline void reset(Field<T, NumberComponents, Architecture::CPU,
+                                   true>& field) {
+      DynamicArray<T, Architecture::CPU>& array = field.getArray();
+      std::fill(array.data(), array.data() + array.size(), (T)0);
+    }
+
+    template <unsigned int NumberComponents>
+    static inline void reset(Field<T, NumberComponents, Architecture::CPU,
+                                   false>& field) {}
+  };
+
+}  // namespace lbm
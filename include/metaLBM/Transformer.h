@@ -1,16 +1,42 @@
 #pragma once
 
 #include <mpi.h>
+#include <cstring>
+#include <vector>
 
 #include <fftw3-mpi.h>
 
 #include "Commons.h"
 #include "Computation.h"
+#include "DynamicArray.h"
 #include "FourierDomain.h"
 #include "MathVector.h"
 
 namespace lbm {
 
+  /// Restores an array overwritten by FFTW planners other than FFTW_ESTIMATE
+  class PlanningBackup {
+  private:
+    double* arrayPtr;
+    DynamicArray<double, Architecture::CPU> backupArray;
+
+  public:
+    PlanningBackup(double* arrayPtr_in, const unsigned int numberElements_in)
+      : arrayPtr(arrayPtr_in)
+      , backupArray(FFTWInit::getIsPlanningDestructive() ? numberElements_in : 0)
+    {
+      if (backupArray.size() > 0) {
+        memcpy(backupArray.data(), arrayPtr, backupArray.size() * sizeof(double));
+      }
+    }
+
+    ~PlanningBackup() {
+      if (backupArray.size() > 0) {
+        memcpy(arrayPtr, backupArray.data(), backupArray.size() * sizeof(double));
+      }
+    }
+  };
+
   template <class T, Architecture architecture, PartitionningType partitionningType,
             unsigned int Dimension, unsigned int NumberComponents>
   class ForwardFFT {};
@@ -19,6 +45,13 @@ namespace lbm {
             unsigned int Dimension, unsigned int NumberComponents>
   class BackwardFFT {};
 
+  /**
+   * Components of a field are stored one after the other with a stride of
+   * FFTWInit::numberElements. Fields with several components are gathered
+   * into the interleaved scratch of FFTWInit so that a single
+   * fftw_mpi_plan_many_dft_r2c plan transforms all of them with one set of
+   * global transposes.
+   */
   template <unsigned int Dimension, unsigned int NumberComponents>
   class ForwardFFT<double, Architecture::CPU, PartitionningType::OneD,
                    Dimension, NumberComponents> {
@@ -27,18 +60,33 @@ namespace lbm {
     double* fourierPtr;
 
  private:
-    fftw_plan planForward[NumberComponents];
+    double* interleavedPtr;
+    fftw_plan planForward;
 
   public:
     ForwardFFT(double* spacePtr_in, double* fourierPtr_in,
                const ptrdiff_t globalLength_in[3])
       : spacePtr(spacePtr_in), fourierPtr(fourierPtr_in)
+      , interleavedPtr(NumberComponents > 1 ? FFTWInit::getInterleavedPtr() : NULL)
     {
-      for (auto iC = 0; iC < NumberComponents; ++iC) {
-        planForward[iC] = fftw_mpi_plan_dft_r2c(
-          Dimension, globalLength_in, spacePtr + FFTWInit::numberElements * iC,
-          (fftw_complex*)(fourierPtr + FFTWInit::numberElements * iC),
-          MPI_COMM_WORLD, FFTW_ESTIMATE);
+      static_assert(NumberComponents <= FFTWInit::maxNumberComponents,
+                    "Interleaved scratch holds at most maxNumberComponents");
+
+      if (NumberComponents > 1) {
+        planForward = fftw_mpi_plan_many_dft_r2c(
+          Dimension, globalLength_in, NumberComponents,
+          FFTW_MPI_DEFAULT_BLOCK, FFTW_MPI_DEFAULT_BLOCK,
+          interleavedPtr, (fftw_complex*)(interleavedPtr),
+          MPI_COMM_WORLD, FFTWInit::getForwardFlag());
+      }
+      else {
+        PlanningBackup spaceBackup(spacePtr, FFTWInit::numberElements);
+        PlanningBackup fourierBackup(fourierPtr,
+          spacePtr == fourierPtr ? 0 : FFTWInit::numberElements);
+
+        planForward = fftw_mpi_plan_dft_r2c(
+          Dimension, globalLength_in, spacePtr, (fftw_complex*)(fourierPtr),
+          MPI_COMM_WORLD, FFTWInit::getForwardFlag());
       }
     }
 
@@ -47,15 +95,48 @@ namespace lbm {
     {}
 
     ~ForwardFFT() {
-      for (auto iC = 0; iC < NumberComponents; ++iC) {
-        fftw_destroy_plan(planForward[iC]);
-      }
+      fftw_destroy_plan(planForward);
     }
 
     LBM_HOST
     inline void execute() {
-      for (auto iC = 0; iC < NumberComponents; ++iC) {
-        fftw_execute(planForward[iC]);
+      if (NumberComponents > 1) {
+        interleave();
+        fftw_execute(planForward);
+        deinterleave();
+      }
+      else {
+        fftw_execute(planForward);
+      }
+    }
+
+  private:
+    LBM_HOST
+    inline void interleave() {
+      const unsigned int numberElements = FFTWInit::numberElements;
+      #pragma omp parallel for schedule(static)
+      for (auto index = 0; index < numberElements; ++index) {
+        for (auto iC = 0; iC < NumberComponents; ++iC) {
+          interleavedPtr[NumberComponents * index + iC] =
+            spacePtr[numberElements * iC + index];
+        }
+      }
+    }
+
+    LBM_HOST
+    inline void deinterleave() {
+      const unsigned int numberElements = FFTWInit::numberElements;
+      const fftw_complex* interleavedComplexPtr = (fftw_complex*)(interleavedPtr);
+      #pragma omp parallel for schedule(static)
+      for (auto index = 0; index < numberElements / 2; ++index) {
+        for (auto iC = 0; iC < NumberComponents; ++iC) {
+          fftw_complex* fourierComponentPtr =
+            (fftw_complex*)(fourierPtr + numberElements * iC);
+          fourierComponentPtr[index][p::Re] =
+            interleavedComplexPtr[NumberComponents * index + iC][p::Re];
+          fourierComponentPtr[index][p::Im] =
+            interleavedComplexPtr[NumberComponents * index + iC][p::Im];
+        }
       }
     }
   };
@@ -68,7 +149,8 @@ namespace lbm {
     double* spacePtr;
 
   private:
-    fftw_plan planBackward[NumberComponents];
+    double* interleavedPtr;
+    fftw_plan planBackward;
     Computation<Architecture::CPU, L::dimD> computationLocal;
 
   public:
@@ -76,14 +158,27 @@ namespace lbm {
                 const ptrdiff_t globalLength_in[3])
       : fourierPtr(fourierPtr_in)
       , spacePtr(spacePtr_in)
+      , interleavedPtr(NumberComponents > 1 ? FFTWInit::getInterleavedPtr() : NULL)
       , computationLocal(lSD::sStart(), lSD::sEnd())
     {
-      for (auto iC = 0; iC < NumberComponents; ++iC) {
-        planBackward[iC] = fftw_mpi_plan_dft_c2r(
-          Dimension, globalLength_in,
-          (fftw_complex*)(fourierPtr + FFTWInit::numberElements * iC),
-          spacePtr + FFTWInit::numberElements * iC, MPI_COMM_WORLD,
-          FFTW_ESTIMATE);
+      static_assert(NumberComponents <= FFTWInit::maxNumberComponents,
+                    "Interleaved scratch holds at most maxNumberComponents");
+
+      if (NumberComponents > 1) {
+        planBackward = fftw_mpi_plan_many_dft_c2r(
+          Dimension, globalLength_in, NumberComponents,
+          FFTW_MPI_DEFAULT_BLOCK, FFTW_MPI_DEFAULT_BLOCK,
+          (fftw_complex*)(interleavedPtr), interleavedPtr,
+          MPI_COMM_WORLD, FFTWInit::getBackwardFlag());
+      }
+      else {
+        PlanningBackup fourierBackup(fourierPtr, FFTWInit::numberElements);
+        PlanningBackup spaceBackup(spacePtr,
+          spacePtr == fourierPtr ? 0 : FFTWInit::numberElements);
+
+        planBackward = fftw_mpi_plan_dft_c2r(
+          Dimension, globalLength_in, (fftw_complex*)(fourierPtr), spacePtr,
+          MPI_COMM_WORLD, FFTWInit::getBackwardFlag());
       }
     }
 
@@ -92,21 +187,53 @@ namespace lbm {
     {}
 
     ~BackwardFFT() {
-      for (auto iC = 0; iC < NumberComponents; ++iC) {
-        fftw_destroy_plan(planBackward[iC]);
-      }
+      fftw_destroy_plan(planBackward);
     }
 
     LBM_HOST
     inline void execute() {
-      for (auto iC = 0; iC < NumberComponents; ++iC) {
-        fftw_execute(planBackward[iC]);
-        computationLocal.Do([=] LBM_HOST(const Position& iP) {
-            (spacePtr + FFTWInit::numberElements * iC)[lSD::getIndex(iP)] /=
-              gSD::sVolume();
+      if (NumberComponents > 1) {
+        interleave();
+        fftw_execute(planBackward);
+        deinterleaveAndNormalize();
+      }
+      else {
+        fftw_execute(planBackward);
+        computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
+            spacePtr[lSD::getIndex(iP)] /= gSD::sVolume();
         });
         computationLocal.synchronize();
+      }
+    }
+
+  private:
+    LBM_HOST
+    inline void interleave() {
+      const unsigned int numberElements = FFTWInit::numberElements;
+      fftw_complex* interleavedComplexPtr = (fftw_complex*)(interleavedPtr);
+      #pragma omp parallel for schedule(static)
+      for (auto index = 0; index < numberElements / 2; ++index) {
+        for (auto iC = 0; iC < NumberComponents; ++iC) {
+          const fftw_complex* fourierComponentPtr =
+            (fftw_complex*)(fourierPtr + numberElements * iC);
+          interleavedComplexPtr[NumberComponents * index + iC][p::Re] =
+            fourierComponentPtr[index][p::Re];
+          interleavedComplexPtr[NumberComponents * index + iC][p::Im] =
+            fourierComponentPtr[index][p::Im];
+        }
+      }
+    }
 
+    LBM_HOST
+    inline void deinterleaveAndNormalize() {
+      const unsigned int numberElements = FFTWInit::numberElements;
+      const double inverseVolume = 1.0 / gSD::sVolume();
+      #pragma omp parallel for schedule(static)
+      for (auto index = 0; index < numberElements; ++index) {
+        for (auto iC = 0; iC < NumberComponents; ++iC) {
+          spacePtr[numberElements * iC + index] =
+            inverseVolume * interleavedPtr[NumberComponents * index + iC];
+        }
       }
     }
   };
@@ -142,15 +269,10 @@ namespace lbm {
 
     LBM_HOST
     inline void executeFourier() {
-      computationFourier.Do([=] LBM_HOST(const Position& iFP) {
+      computationFourier.DoParallel([=] LBM_HOST(const Position& iFP) {
           auto index = lFD::getIndex(iFP);
 
-          WaveNumber iK{{0}};
-
-          iK[d::X] = iFP[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-            ? iFP[d::X] + offset[d::X] : iFP[d::X] + offset[d::X] - gSD::sLength()[d::X];
-          iK[d::Y] = iFP[d::Y] <= gSD::sLength()[d::Y] / 2
-            ? iFP[d::Y] : iFP[d::Y] - gSD::sLength()[d::Y];
+          WaveNumber iK = gFD::getWaveNumber(iFP, offset);
 
           ((fftw_complex*)(backwardOut.fourierPtr))[index][p::Re] =
             - iK[d::X] * ((fftw_complex*)(forwardIn.fourierPtr
@@ -178,7 +300,7 @@ namespace lbm {
 
     LBM_HOST
     inline void normalize() {
-      computationLocal.Do([=] LBM_HOST(const Position& iP) {
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
           backwardOut.fourierPtr[lSD::getIndex(iP)] /= gSD::sVolume();
       });
       computationLocal.synchronize();
@@ -196,7 +318,7 @@ namespace lbm {
     BackwardFFT<double, Architecture::CPU, PartitionningType::OneD, 3, 3>
     backwardOut;
 
-    const Position& offset;
+    const Position offset;
     Computation<Architecture::CPU, 3> computationFourier;
     Computation<Architecture::CPU, 3> computationLocal;
 
@@ -213,19 +335,10 @@ namespace lbm {
 
     LBM_HOST
     inline void executeFourier() {
-      computationFourier.Do([=] LBM_HOST(const Position& iFP) {
+      computationFourier.DoParallel([=] LBM_HOST(const Position& iFP) {
         auto index = lFD::getIndex(iFP);
 
-        WaveNumber iK{{0}};
-        iK[d::X] = iFP[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-          ? iFP[d::X] + offset[d::X]
-          : iFP[d::X] + offset[d::X] - gSD::sLength()[d::X];
-        iK[d::Y] = iFP[d::Y] <= gSD::sLength()[d::Y] / 2
-            ? iFP[d::Y]
-          : iFP[d::Y] - gSD::sLength()[d::Y];
-        iK[d::Z] = iFP[d::Z] <= gSD::sLength()[d::Z] / 2
-          ? iFP[d::Z]
-          : iFP[d::Z] - gSD::sLength()[d::Z];
+        WaveNumber iK = gFD::getWaveNumber(iFP, offset);
 
         ((fftw_complex*)(backwardOut.fourierPtr +
                          FFTWInit::numberElements * (d::X)))[index][p::Re] =
@@ -284,7 +397,7 @@ namespace lbm {
     LBM_HOST
     inline void normalize() {
       const unsigned int numberElements = FFTWInit::numberElements;
-      computationLocal.Do([=] LBM_HOST(const Position& iP) {
+      computationLocal.DoParallel([=] LBM_HOST(const Position& iP) {
           for (auto iC = 0; iC < 3; ++iC) {
             (backwardOut.fourierPtr + numberElements * iC)[lSD::getIndex(iP)] /=
               gSD::sVolume();
@@ -304,7 +417,7 @@ namespace lbm {
     fftw_complex* fourierInPtr;
     BackwardFFT<double, Architecture::CPU, PartitionningType::OneD, 2, 2>
     backwardOut;
-    const Position& offset;
+    const Position offset;
     Computation<Architecture::CPU, L::dimD> computationFourier;
 
   public:
@@ -318,17 +431,10 @@ namespace lbm {
 
     LBM_HOST
     inline void executeFourier() {
-      computationFourier.Do([=] LBM_HOST(const Position& iFP) {
-          WaveNumber iK{{0}};
-          Position iFP_symmetric{{0}};
-          WaveNumber iK_symmetric{{0}};
-
+      computationFourier.DoParallel([=] LBM_HOST(const Position& iFP) {
           auto index = lFD::getIndex(iFP);
 
-          iK[d::X] = iFP[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-            ? iFP[d::X] + offset[d::X] : iFP[d::X] + offset[d::X] - gSD::sLength()[d::X];
-          iK[d::Y] = iFP[d::Y] <= gSD::sLength()[d::Y] / 2
-            ? iFP[d::Y] : iFP[d::Y] - gSD::sLength()[d::Y];
+          WaveNumber iK = gFD::getWaveNumber(iFP, offset);
 
           ((fftw_complex*)(backwardOut.fourierPtr +
                        FFTWInit::numberElements * (d::X)))[index][p::Re]
@@ -345,39 +451,6 @@ namespace lbm {
           ((fftw_complex*)(backwardOut.fourierPtr +
                            FFTWInit::numberElements * (d::Y)))[index][p::Im]
             = -iK[d::X] * fourierInPtr[index][p::Re];
-
-          if (iFP[d::Y] == 0) {
-            iFP_symmetric[d::X] = gSD::sLength()[d::X] - iFP[d::X];
-            if (iFP_symmetric[d::X] < lFD::length()[d::X]) {
-              iFP_symmetric[d::Y] = 0;
-
-              iK_symmetric[d::X] =
-                iFP_symmetric[d::X] + offset[d::X] <= gSD::sLength()[d::X] / 2
-                ? iFP_symmetric[d::X] + offset[d::X]
-                : iFP_symmetric[d::X] + offset[d::X] - gSD::sLength()[d::X];
-              iK_symmetric[d::Y] =
-                iFP_symmetric[d::Y] <= gSD::sLength()[d::Y] / 2
-                ? iFP_symmetric[d::Y]
-                : iFP_symmetric[d::Y] - gSD::sLength()[d::Y];
-
-              auto index_symmetric = lFD::getIndex(iFP_symmetric);
-              ((fftw_complex*)(backwardOut.fourierPtr +
-                               FFTWInit::numberElements * (d::X)))[index_symmetric][p::Re] =
-                -iK_symmetric[d::Y] * fourierInPtr[index_symmetric][p::Im];
-
-              ((fftw_complex*)(backwardOut.fourierPtr +
-                               FFTWInit::numberElements * (d::X)))[index_symmetric][p::Im] =
-                iK_symmetric[d::Y] * fourierInPtr[index_symmetric][p::Re];
-
-              ((fftw_complex*)(backwardOut.fourierPtr +
-                               FFTWInit::numberElements * (d::Y)))[index_symmetric][p::Re] =
-            iK_symmetric[d::X] * fourierInPtr[index_symmetric][p::Im];
-
-              ((fftw_complex*)(backwardOut.fourierPtr +
-                               FFTWInit::numberElements * (d::Y)))[index_symmetric][p::Im] =
-                -iK_symmetric[d::X] * fourierInPtr[index_symmetric][p::Re];
-            }
-          }
       });
       computationFourier.synchronize();
 
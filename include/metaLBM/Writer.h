@@ -1,18 +1,26 @@
 #pragma once
 
 #include <hdf5.h>
+#include <mpi.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "Commons.h"
+#include "Computation.h"
 #include "Distribution.h"
 #include "Domain.h"
 #include "Field.h"
 #include "MathVector.h"
 #include "Options.h"
+#include "OutputPipeline.h"
 
 namespace lbm {
 
@@ -28,6 +36,7 @@ namespace lbm {
     const std::string filePrefix;
     const std::string fileFormat;
 
+    std::vector<char> fileBuffer;
     std::ofstream file;
 
     Writer(const std::string& writerFolder_in,
@@ -53,6 +62,12 @@ namespace lbm {
       return writeFolder + writerFolder + filePrefix + postfix + fileExtension;
     }
 
+    /// Stream buffer of bufferSize bytes, set before the file is first opened
+    inline void setFileBuffer(const unsigned int bufferSize) {
+      fileBuffer.resize(bufferSize);
+      file.rdbuf()->pubsetbuf(fileBuffer.data(), fileBuffer.size());
+    }
+
   public:
     inline bool getIsWritten(const unsigned int iteration) {
       bool isWritten = false;
@@ -102,6 +117,14 @@ namespace lbm {
     inline void write(const U data) {
       Base::file << data;
     }
+
+    inline void writeSeparator() {
+      Base::file << " ";
+    }
+
+    inline void writeEndOfLine() {
+      Base::file << "\n";
+    }
   };
 
   template <class T>
@@ -117,7 +140,6 @@ namespace lbm {
       : Base(writerFolder_in + "/", filePrefix_in, fileExtension_in, "binary")
     {}
 
-    using Base::getIsBackedUp;
     using Base::getIsWritten;
 
   protected:
@@ -135,6 +157,10 @@ namespace lbm {
     inline void write(U data) {
       Base::file.write(reinterpret_cast<char*>(&data), sizeof(data));
     }
+
+    inline void writeSeparator() {}
+
+    inline void writeEndOfLine() {}
   };
 
   template <class T, InputOutputFormat inputOutputFormat>
@@ -144,6 +170,7 @@ namespace lbm {
     using Base = Writer<T, InputOutput::Generic, inputOutputFormat>;
     unsigned int startIteration;
     unsigned int analysisStep;
+    std::chrono::steady_clock::time_point flushTime;
 
   public:
     ScalarAnalysisWriter(const std::string& writerFolder_in,
@@ -153,30 +180,49 @@ namespace lbm {
       : Base(writerFolder_in, filePrefix_in, ".dat")
       , startIteration(startIteration_in)
       , analysisStep(analysisStep_in)
-    {}
+      , flushTime(std::chrono::steady_clock::now())
+    {
+      Base::setFileBuffer(analysisBufferSize);
+    }
+
+    ~ScalarAnalysisWriter() {
+      Base::file.close();
+    }
 
     inline bool getIsAnalyzed(const unsigned int iteration) {
       return (iteration % analysisStep) == 0;
     }
 
+    /// The file is opened once and kept open for the run
     inline void openFile(const unsigned int iteration) {
-      Base::openAndAppend(Base::getFileName("_"+std::to_string(startIteration)));
+      if (!Base::file.is_open()) {
+        Base::openAndAppend(Base::getFileName("_"+std::to_string(startIteration)));
+      }
     }
 
-    inline void closeFile() { Base::file.close(); }
+    /// Records stay buffered until the buffer fills or analysisFlushPeriod elapses
+    inline void closeFile() {
+      const auto currentTime = std::chrono::steady_clock::now();
+
+      if (std::chrono::duration<double>(currentTime - flushTime).count()
+          >= analysisFlushPeriod) {
+        Base::file.flush();
+        flushTime = currentTime;
+      }
+    }
 
     template <unsigned int NumberScalarAnalyses>
     void writeAnalysis(const unsigned int iteration, T* data) {
       LBM_INSTRUMENT_ON("ScalarAnalysisWriter::writeAnalysis<NumberScalarAnalysis>", 3)
 
         Base::write(iteration);
-      Base::file << " ";
+      Base::writeSeparator();
 
       for (auto iS = 0; iS < NumberScalarAnalyses; ++iS) {
         Base::write(data[iS]);
-        Base::file << " ";
+        Base::writeSeparator();
       }
-      Base::file << std::endl;
+      Base::writeEndOfLine();
     }
 
     void writeHeader(const std::string& header) {
@@ -184,9 +230,7 @@ namespace lbm {
 
         Base::openAndTruncate(Base::getFileName("_"+std::to_string(startIteration)));
 
-      Base::file << header << std::endl;
-
-      closeFile();
+      Base::file << header << "\n";
     }
   };
 
@@ -197,6 +241,7 @@ namespace lbm {
     using Base = Writer<T, InputOutput::Generic, inputOutputFormat>;
     unsigned int startIteration;
     unsigned int analysisStep;
+    std::chrono::steady_clock::time_point flushTime;
 
   public:
     SpectralAnalysisWriter(const std::string& writerFolder_in,
@@ -206,17 +251,36 @@ namespace lbm {
       : Base(writerFolder_in, filePrefix_in, ".dat")
       , startIteration(startIteration_in)
       , analysisStep(analysisStep_in)
-    {}
+      , flushTime(std::chrono::steady_clock::now())
+    {
+      Base::setFileBuffer(analysisBufferSize);
+    }
+
+    ~SpectralAnalysisWriter() {
+      Base::file.close();
+    }
 
     inline bool getIsAnalyzed(const unsigned int iteration) {
       return (iteration % analysisStep) == 0;
     }
 
+    /// The file is opened once and kept open for the run
     inline void openFile(const unsigned int iteration) {
-      Base::openAndAppend(Base::getFileName("_"+std::to_string(startIteration)));
+      if (!Base::file.is_open()) {
+        Base::openAndAppend(Base::getFileName("_"+std::to_string(startIteration)));
+      }
     }
 
-    inline void closeFile() { Base::file.close(); }
+    /// Records stay buffered until the buffer fills or analysisFlushPeriod elapses
+    inline void closeFile() {
+      const auto currentTime = std::chrono::steady_clock::now();
+
+      if (std::chrono::duration<double>(currentTime - flushTime).count()
+          >= analysisFlushPeriod) {
+        Base::file.flush();
+        flushTime = currentTime;
+      }
+    }
 
     template <unsigned int NumberSpectralAnalyses, unsigned int MaxWaveNumber>
     void writeAnalysis(const unsigned int iteration,
@@ -225,16 +289,16 @@ namespace lbm {
 
         for (auto kNorm = 0; kNorm < MaxWaveNumber; ++kNorm) {
           Base::write(iteration);
-          Base::file << " ";
+          Base::writeSeparator();
 
           Base::write(kNorm);
-          Base::file << " ";
+          Base::writeSeparator();
 
           for (auto iS = 0; iS < NumberSpectralAnalyses; ++iS) {
             Base::write(data[iS][kNorm]);
-            Base::file << " ";
+            Base::writeSeparator();
           }
-          Base::file << std::endl;
+          Base::writeEndOfLine();
         }
     }
 
@@ -243,21 +307,221 @@ namespace lbm {
 
         Base::openAndTruncate(Base::getFileName("_"+std::to_string(startIteration)));
 
-      Base::file << header << std::endl;
+      Base::file << header << "\n";
+    }
+  };
+
+  /**
+   * Probe time series as raw binary blocks of records, each holding the
+   * iteration then the values of every probe in global order. Probe
+   * positions are listed once in an ascii file alongside.
+   */
+  template <class T>
+  class ProbeWriter
+    : public Writer<T, InputOutput::Generic, InputOutputFormat::binary> {
+  private:
+    using Base = Writer<T, InputOutput::Generic, InputOutputFormat::binary>;
+    const std::string fileName;
 
-      closeFile();
+  public:
+    ProbeWriter(const std::string& writerFolder_in,
+                const unsigned int startIteration_in)
+      : Base(writerFolder_in, "probes", ".bin")
+      , fileName(Base::getFileName("_" + std::to_string(startIteration_in)))
+    {}
+
+    ~ProbeWriter() {
+      Base::file.close();
+    }
+
+    void writeHeader(const std::vector<Position>& positions,
+                     const std::string& valueNames) {
+      LBM_INSTRUMENT_ON("ProbeWriter::writeHeader", 2)
+
+      std::ofstream positionFile(Base::writeFolder + Base::writerFolder
+                                 + Base::filePrefix + "_positions.dat",
+                                 std::ofstream::out | std::ofstream::trunc);
+      positionFile << "# record: iteration, then per probe: " << valueNames << "\n"
+                   << "# probe x y z\n";
+      for (auto iProbe = 0; iProbe < positions.size(); ++iProbe) {
+        positionFile << iProbe << " " << positions[iProbe][d::X] << " "
+                     << positions[iProbe][d::Y] << " "
+                     << positions[iProbe][d::Z] << "\n";
+      }
+
+      Base::openAndTruncate(fileName);
+    }
+
+    inline void writeBlock(const T* dataPtr, const unsigned int numberValues) {
+      LBM_INSTRUMENT_ON("ProbeWriter::writeBlock", 3)
+
+      if (!Base::file.is_open()) {
+        Base::openAndAppend(fileName);
+      }
+
+      Base::file.write(reinterpret_cast<const char*>(dataPtr),
+                       numberValues * sizeof(T));
+      Base::file.flush();
     }
   };
 
   template <class T, InputOutput inputOutput>
   class FieldWriter {};
 
+  /**
+   * Storage of an HDF5 field dataset. Chunks tile the local block of each
+   * process, split into numberChunks slabs along X, so that no chunk is
+   * shared between processes during collective filtered writes. Zero
+   * chunks store the dataset contiguously, without filters. A lossy error
+   * bound rounds values to a power-of-two step before the filters, which
+   * zeroes the trailing mantissa bits that shuffle and deflate then remove.
+   */
+  struct DatasetLayout {
+    unsigned int numberChunks;
+    CompressionType compressionT;
+    unsigned int compressionLevel;
+    unsigned int filterID;
+    std::vector<unsigned int> filterParameters;
+    ErrorBound errorBound;
+
+    DatasetLayout(const unsigned int numberChunks_in = numberChunksX,
+                  const CompressionType compressionT_in = lbm::compressionT,
+                  const unsigned int compressionLevel_in = lbm::compressionLevel,
+                  const unsigned int filterID_in = compressionFilterID,
+                  const ErrorBound& errorBound_in = {ErrorBoundType::None, 0})
+      : numberChunks(numberChunks_in)
+      , compressionT(compressionT_in)
+      , compressionLevel(compressionLevel_in)
+      , filterID(filterID_in)
+      , errorBound(errorBound_in)
+    {
+      if (numberChunks == 0) {
+        compressionT = CompressionType::None;
+      }
+      else if (lSD::sLength()[d::X] % numberChunks != 0) {
+        if (MPIInit::rank[d::X] == 0) {
+          std::cout << "Local length not divisible into " << numberChunks
+                    << " chunks, using one chunk per process\n";
+        }
+        numberChunks = 1;
+      }
+
+#if !H5_VERSION_GE(1, 10, 2)
+      if (compressionT != CompressionType::None && MPIInit::rank[d::X] == 0) {
+        std::cout << "Parallel HDF5 older than 1.10.2 cannot write filtered "
+                  << "datasets, writing uncompressed\n";
+      }
+      compressionT = CompressionType::None;
+#endif
+    }
+
+    /// Default layout whose values are quantized within errorBound_in
+    static inline DatasetLayout getLossy(const ErrorBound& errorBound_in) {
+      return DatasetLayout(numberChunksX, lbm::compressionT,
+                           lbm::compressionLevel, compressionFilterID,
+                           errorBound_in);
+    }
+
+    /// Collective for relative bounds, 0 when values are kept exact. The
+    /// maximum skips the FFTW padding, which may hold undefined values
+    template <class T>
+    inline T getQuantizationStep(const T* dataPtr) const {
+      T absoluteBound = errorBound.value;
+
+      if (errorBound.errorBoundT == ErrorBoundType::None) {
+        return 0;
+      }
+      else if (errorBound.errorBoundT == ErrorBoundType::Relative) {
+        T localMax = 0;
+        Computation<Architecture::CPU, L::dimD> computationLocal(lSD::sStart(),
+                                                                 lSD::sEnd());
+        computationLocal.Do([&] LBM_HOST(const Position& iP) {
+            localMax = std::max(localMax, (T)fabs(dataPtr[lSD::getIndex(iP)]));
+          });
+        computationLocal.synchronize();
+
+        T globalMax = 0;
+        MPI_Allreduce(&localMax, &globalMax, 1, MPI_DOUBLE, MPI_MAX,
+                      MPI_COMM_WORLD);
+        absoluteBound *= globalMax;
+      }
+
+      if (absoluteBound <= 0) return 0;
+      return std::ldexp((T)1, std::ilogb(2 * absoluteBound));
+    }
+
+    /// Copies lSD::pVolume() values rounded to multiples of quantizationStep
+    template <class T>
+    static inline void quantize(const T* dataPtr, T* quantizedPtr,
+                                const T quantizationStep) {
+      if (quantizationStep == 0) {
+        std::copy(dataPtr, dataPtr + lSD::pVolume(), quantizedPtr);
+        return;
+      }
+
+      for (auto i = 0; i < lSD::pVolume(); ++i) {
+        quantizedPtr[i] =
+          quantizationStep * std::nearbyint(dataPtr[i] / quantizationStep);
+      }
+    }
+
+    /// Dataset creation property list for local blocks of localLength, to
+    /// be closed by the caller. Time series add a leading time dimension,
+    /// one snapshot per chunk.
+    inline hid_t createPropertyList(const Position& localLength,
+                                    const bool isTimeSeries = false) const {
+      hid_t propertyList = H5Pcreate(H5P_DATASET_CREATE);
+      if (numberChunks == 0 && !isTimeSeries) return propertyList;
+
+      hsize_t chunkDimensions[4] = {1, 1, 1, 1};
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        chunkDimensions[isTimeSeries + iD] = localLength[iD];
+      }
+      if (numberChunks > 0) {
+        chunkDimensions[isTimeSeries + d::X] /= numberChunks;
+      }
+
+      H5Pset_chunk(propertyList, L::dimD + isTimeSeries, chunkDimensions);
+      H5Pset_fill_time(propertyList, H5D_FILL_TIME_NEVER);
+
+      if (compressionT == CompressionType::ShuffleDeflate) {
+        H5Pset_shuffle(propertyList);
+      }
+
+      if (compressionT == CompressionType::Deflate
+          || compressionT == CompressionType::ShuffleDeflate) {
+        H5Pset_deflate(propertyList, compressionLevel);
+      }
+      else if (compressionT == CompressionType::Plugin) {
+        if (H5Zfilter_avail(filterID) > 0) {
+          H5Pset_filter(propertyList, filterID, H5Z_FLAG_OPTIONAL,
+                        filterParameters.size(), filterParameters.data());
+        }
+        else if (MPIInit::rank[d::X] == 0) {
+          std::cout << "HDF5 filter " << filterID
+                    << " not available, writing uncompressed\n";
+        }
+      }
+
+      return propertyList;
+    }
+  };
+
   template <class T>
   class FieldWriter<T, InputOutput::HDF5>
     : public Writer<T, InputOutput::Generic, InputOutputFormat::Generic> {
   private:
     using Base = Writer<T, InputOutput::Generic, InputOutputFormat::Generic>;
 
+  protected:
+    /// Dataset copied into a staging buffer, written later by the I/O thread
+    struct StagedDataset {
+      std::string name;
+      unsigned int numberComponents;
+      unsigned int begin;
+      T quantizationStep;
+    };
+
   protected:
     hid_t fileHDF5;
     hid_t datasetHDF5;
@@ -269,11 +533,39 @@ namespace lbm {
     hid_t propertyListHDF5;
     FieldWriter<T, InputOutput::XDMF> writerXDMF;
 
+    const bool isTimeSeries;
+    const bool isPadded;
+    const std::string seriesPostfix;
+    bool isSeriesOpen;
+    unsigned int numberSnapshots;
+
+    std::map<std::string, DatasetLayout> datasetLayouts;
+    std::vector<T> quantizedArray;
+    std::map<std::string, std::vector<int>> fileAttributes;
+
+    OutputPipeline<T>* outputPipelinePtr;
+    unsigned int stagedBuffer;
+    unsigned int stagedIteration;
+    std::vector<StagedDataset> stagedDatasets;
+
   public:
     FieldWriter(const std::string& filePrefix_in,
-                const std::string& name_in = "field")
+                const std::string& name_in = "field",
+                const bool isTimeSeries_in = writeTimeSeries,
+                const bool isPadded_in = true,
+                const unsigned int startIteration_in = startIteration)
       : Base(filePrefix_in + "/", name_in, ".h5", "binary")
-      , writerXDMF(filePrefix_in, name_in)
+      , writerXDMF(filePrefix_in, name_in, isTimeSeries_in,
+                   "_" + std::to_string(startIteration_in))
+      , isTimeSeries(isTimeSeries_in)
+      , isPadded(isPadded_in)
+      , seriesPostfix("_" + std::to_string(startIteration_in))
+      , isSeriesOpen(false)
+      , numberSnapshots(0)
+      , datasetLayouts{{"", DatasetLayout()}}
+      , outputPipelinePtr(NULL)
+      , stagedBuffer(0)
+      , stagedIteration(0)
     {
       if (MPIInit::rank[d::X] == 0) {
         int dirError = mkdir(Base::writeFolder.c_str(),
@@ -288,86 +580,314 @@ namespace lbm {
       }
     }
 
+    /// The time series file stays open until the writer is destroyed. It is
+    /// suffixed with the start iteration, so a restart never truncates it
+    ~FieldWriter() {
+      if (isSeriesOpen) {
+        statusHDF5 = H5Fclose(fileHDF5);
+      }
+    }
+
+    using Base::getFileName;
     using Base::getIsWritten;
 
-    inline void openFile(const unsigned int iteration) {
-      std::string fileName = Base::getFileName(iteration);
-      open(fileName);
+    /// Applies to every dataset whose name starts with prefix, "" for all
+    inline void setDatasetLayout(const std::string& prefix,
+                                 const DatasetLayout& datasetLayout) {
+      datasetLayouts.erase(prefix);
+      datasetLayouts.insert(std::make_pair(prefix, datasetLayout));
+    }
 
-      if (MPIInit::rank[d::X] == 0) {
-        writerXDMF.openFile(iteration);
+    /// Layout registered under the longest prefix of name
+    inline const DatasetLayout& getDatasetLayout(const std::string& name) const {
+      auto layoutIterator = datasetLayouts.find("");
+
+      for (auto iL = datasetLayouts.begin(); iL != datasetLayouts.end(); ++iL) {
+        if (name.compare(0, iL->first.size(), iL->first) == 0
+            && iL->first.size() > layoutIterator->first.size()) {
+          layoutIterator = iL;
+        }
       }
+
+      return layoutIterator->second;
     }
 
-    inline void closeFile() {
-      statusHDF5 = H5Fclose(fileHDF5);
+    /// Files are then only staged here and written by the pipeline
+    inline void setOutputPipeline(OutputPipeline<T>* outputPipelinePtr_in) {
+      outputPipelinePtr = outputPipelinePtr_in;
+    }
 
-      if (MPIInit::rank[d::X] == 0) {
-        writerXDMF.closeFile();
+    /// Attribute of the file root written whenever a file is created
+    inline void setFileAttribute(const std::string& name,
+                                 const std::vector<int>& values) {
+      fileAttributes[name] = values;
+    }
+
+    inline void openFile(const unsigned int iteration) {
+      if (outputPipelinePtr) {
+        stagedBuffer = outputPipelinePtr->acquireBuffer();
+        outputPipelinePtr->getBuffer(stagedBuffer).clear();
+        stagedIteration = iteration;
+        stagedDatasets.clear();
+      }
+      else {
+        openFileNow(iteration, fileAttributes);
       }
     }
 
-    template <unsigned int NumberComponents, Architecture architecture>
-    void writeField(Field<T, NumberComponents, architecture, true>& field) {
+    /// File attributes are copied as well, they may change before the write
+    inline void closeFile() {
+      if (outputPipelinePtr) {
+        const unsigned int iteration = stagedIteration;
+        const unsigned int iB = stagedBuffer;
+        const std::vector<StagedDataset> datasets = stagedDatasets;
+        const std::map<std::string, std::vector<int>> attributes = fileAttributes;
+
+        outputPipelinePtr->submit(iB, [=] {
+            const T* bufferPtr = outputPipelinePtr->getBuffer(iB).data();
+
+            openFileNow(iteration, attributes);
+            for (auto iS = 0; iS < datasets.size(); ++iS) {
+              writeDatasetNow(datasets[iS].name, bufferPtr + datasets[iS].begin,
+                              datasets[iS].numberComponents,
+                              datasets[iS].quantizationStep);
+            }
+            closeFileNow();
+          });
+      }
+      else {
+        closeFileNow();
+      }
+    }
+
+    template <unsigned int NumberComponents, Architecture architecture,
+              bool IsTransformed>
+    void writeField(Field<T, NumberComponents, architecture, true, IsTransformed>& field) {
       LBM_INSTRUMENT_ON("Writer<HDF5>::writeField<NumberComponents>",3)
 
-        std::string fieldName = field.fieldName;
-      propertyListHDF5 = H5Pcreate(H5P_DATASET_XFER);
+      std::string fieldName = field.fieldName;
 
       for (auto iC = 0; iC < NumberComponents; ++iC) {
         if (NumberComponents > 1) {
           fieldName = field.fieldName + dName[iC];
         }
-        fileSpaceHDF5 = H5Screate_simple(
-                                         L::dimD,
-                                         Project<hsize_t, unsigned int, L::dimD>::Do(gSD::pLength()).data(),
-                                         NULL);
+
+        writeDataset(fieldName, field.getData(field.getNumberElements(), iC),
+                     NumberComponents);
+      }
+    }
+
+    template <unsigned int NumberComponents, Architecture architecture,
+              bool IsTransformed>
+    void writeField(Field<T, NumberComponents, architecture, false, IsTransformed>& field) {}
+
+    /// Writes or stages one local block of lSD::pVolume() values
+    inline void writeDataset(const std::string& name, const T* dataPtr,
+                             const unsigned int numberComponents) {
+      const DatasetLayout& datasetLayout = getDatasetLayout(name);
+      const T quantizationStep = datasetLayout.getQuantizationStep(dataPtr);
+
+      if (outputPipelinePtr) {
+        std::vector<T>& buffer = outputPipelinePtr->getBuffer(stagedBuffer);
+        StagedDataset stagedDataset = {name, numberComponents,
+                                       (unsigned int)buffer.size(),
+                                       quantizationStep};
+
+        buffer.resize(buffer.size() + lSD::pVolume());
+        DatasetLayout::quantize(dataPtr, buffer.data() + stagedDataset.begin,
+                                quantizationStep);
+        stagedDatasets.push_back(stagedDataset);
+      }
+      else if (quantizationStep > 0) {
+        quantizedArray.resize(lSD::pVolume());
+        DatasetLayout::quantize(dataPtr, quantizedArray.data(), quantizationStep);
+        writeDatasetNow(name, quantizedArray.data(), numberComponents,
+                        quantizationStep);
+      }
+      else {
+        writeDatasetNow(name, dataPtr, numberComponents, 0);
+      }
+    }
+
+  protected:
+    inline void openFileNow(const unsigned int iteration,
+                            const std::map<std::string, std::vector<int>>& attributes) {
+      if (!isTimeSeries) {
+        open(Base::getFileName(iteration), attributes);
+      }
+      else if (!isSeriesOpen) {
+        open(Base::getFileName(seriesPostfix), attributes);
+        isSeriesOpen = true;
+      }
+
+      if (isTimeSeries) {
+        writeIterationNow(iteration);
+      }
+
+      if (MPIInit::rank[d::X] == 0) {
+        writerXDMF.openFile(iteration);
+      }
+    }
+
+    inline void closeFileNow() {
+      if (isTimeSeries) {
+        statusHDF5 = H5Fflush(fileHDF5, H5F_SCOPE_LOCAL);
+        ++numberSnapshots;
+      }
+      else {
+        statusHDF5 = H5Fclose(fileHDF5);
+      }
+
+      if (MPIInit::rank[d::X] == 0) {
+        writerXDMF.closeFile();
+      }
+    }
+
+    /// Reads the local block through memorySpaceHDF5 when one is given,
+    /// else contiguously from dataPtr
+    void writeDatasetNow(const std::string& name, const T* dataPtr,
+                         const unsigned int numberComponents,
+                         const T quantizationStep,
+                         const hid_t memorySpaceHDF5 = H5I_INVALID_HID) {
+      propertyListHDF5 = H5Pcreate(H5P_DATASET_XFER);
+
+      /// Time series datasets have a leading, unlimited time dimension
+      const unsigned int rankHDF5 = L::dimD + isTimeSeries;
+      const Position localBlock = isPadded ? lSD::pLength() : lSD::sLength();
+      hsize_t globalLength[4] = {numberSnapshots + 1};
+      hsize_t maximumLength[4] = {H5S_UNLIMITED};
+      hsize_t localLength[4] = {1};
+      hsize_t localOffset[4] = {numberSnapshots};
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        globalLength[isTimeSeries + iD] =
+          isPadded ? gSD::pLength()[iD] : gSD::sLength()[iD];
+        maximumLength[isTimeSeries + iD] = globalLength[isTimeSeries + iD];
+        localLength[isTimeSeries + iD] = localBlock[iD];
+        localOffset[isTimeSeries + iD] = isPadded
+          ? gSD::pOffset(MPIInit::rank)[iD] : gSD::sOffset(MPIInit::rank)[iD];
+      }
+
+      if (isTimeSeries && H5Lexists(fileHDF5, name.c_str(), H5P_DEFAULT) > 0) {
+        dataSetHDF5 = H5Dopen2(fileHDF5, name.c_str(), H5P_DEFAULT);
+        statusHDF5 = H5Dset_extent(dataSetHDF5, globalLength);
+      }
+      else {
+        const hid_t creationListHDF5 =
+          getDatasetLayout(name).createPropertyList(localBlock, isTimeSeries);
+
+        fileSpaceHDF5 = H5Screate_simple(rankHDF5, globalLength,
+                                         isTimeSeries ? maximumLength : NULL);
 
         dataSetHDF5 =
-          H5Dcreate2(fileHDF5, (fieldName).c_str(), H5T_NATIVE_DOUBLE,
-                     fileSpaceHDF5, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+          H5Dcreate2(fileHDF5, name.c_str(), H5T_NATIVE_DOUBLE,
+                     fileSpaceHDF5, H5P_DEFAULT, creationListHDF5, H5P_DEFAULT);
 
         statusHDF5 = H5Sclose(fileSpaceHDF5);
+        statusHDF5 = H5Pclose(creationListHDF5);
+      }
 
-        dataSpaceHDF5 = H5Screate_simple(
-                                         L::dimD,
-                                         Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(),
-                                         NULL);
+      dataSpaceHDF5 = memorySpaceHDF5 != H5I_INVALID_HID
+        ? memorySpaceHDF5 : H5Screate_simple(rankHDF5, localLength, NULL);
 
-        fileSpaceHDF5 = H5Dget_space(dataSetHDF5);
+      fileSpaceHDF5 = H5Dget_space(dataSetHDF5);
 
-        H5Sselect_hyperslab(
-                            fileSpaceHDF5, H5S_SELECT_SET,
-                            Project<hsize_t, unsigned int, L::dimD>::Do(gSD::pOffset(MPIInit::rank))
-                            .data(),
-                            NULL,
-                            Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(),
-                            NULL);
+      H5Sselect_hyperslab(fileSpaceHDF5, H5S_SELECT_SET, localOffset, NULL,
+                          localLength, NULL);
+
+      H5Pset_dxpl_mpio(propertyListHDF5, H5FD_MPIO_COLLECTIVE);
 
-        H5Pset_dxpl_mpio(propertyListHDF5, H5FD_MPIO_COLLECTIVE);
+      statusHDF5 =
+        H5Dwrite(dataSetHDF5, H5T_NATIVE_DOUBLE, dataSpaceHDF5, fileSpaceHDF5,
+                 propertyListHDF5, dataPtr);
 
-        statusHDF5 =
-          H5Dwrite(dataSetHDF5, H5T_NATIVE_DOUBLE, dataSpaceHDF5, fileSpaceHDF5,
-                   propertyListHDF5, field.getData(FFTWInit::numberElements, iC));
+      if (quantizationStep > 0) {
+        const std::string snapshot =
+          isTimeSeries ? "-" + std::to_string(numberSnapshots) : "";
+        writeAttribute("quantization_step" + snapshot, quantizationStep);
+        writeAttribute("error_bound" + snapshot, quantizationStep / 2);
+      }
 
-        statusHDF5 = H5Dclose(dataSetHDF5);
+      statusHDF5 = H5Dclose(dataSetHDF5);
+      if (memorySpaceHDF5 == H5I_INVALID_HID) {
         statusHDF5 = H5Sclose(dataSpaceHDF5);
-        statusHDF5 = H5Sclose(fileSpaceHDF5);
+      }
+      statusHDF5 = H5Sclose(fileSpaceHDF5);
 
-        if (MPIInit::rank[d::X] == 0) {
-          writerXDMF.write(fieldName, NumberComponents);
-        }
+      if (MPIInit::rank[d::X] == 0) {
+        writerXDMF.write(name, numberComponents);
       }
 
       statusHDF5 = H5Pclose(propertyListHDF5);
     }
 
-    template <unsigned int NumberComponents, Architecture architecture>
-    void writeField(Field<T, NumberComponents, architecture, false>& field) {}
+    /**
+     * Iteration of each snapshot in a 1D extendible dataset, so that a time
+     * series can be read without its XDMF file. Rank 0 writes the value.
+     */
+    inline void writeIterationNow(const unsigned int iteration) {
+      const int value = iteration;
+      const hsize_t globalLength[1] = {numberSnapshots + 1};
+      const hsize_t maximumLength[1] = {H5S_UNLIMITED};
+      const hsize_t localLength[1] = {1};
+      const hsize_t localOffset[1] = {numberSnapshots};
+
+      hid_t iterationHDF5;
+      if (H5Lexists(fileHDF5, "iteration", H5P_DEFAULT) > 0) {
+        iterationHDF5 = H5Dopen2(fileHDF5, "iteration", H5P_DEFAULT);
+        statusHDF5 = H5Dset_extent(iterationHDF5, globalLength);
+      }
+      else {
+        const hsize_t chunkLength[1] = {1024};
+        const hid_t creationListHDF5 = H5Pcreate(H5P_DATASET_CREATE);
+        H5Pset_chunk(creationListHDF5, 1, chunkLength);
 
-    inline void open(const std::string& fileName) {
+        const hid_t spaceHDF5 = H5Screate_simple(1, globalLength, maximumLength);
+        iterationHDF5 = H5Dcreate2(fileHDF5, "iteration", H5T_NATIVE_INT, spaceHDF5,
+                                   H5P_DEFAULT, creationListHDF5, H5P_DEFAULT);
+
+        statusHDF5 = H5Sclose(spaceHDF5);
+        statusHDF5 = H5Pclose(creationListHDF5);
+      }
+
+      const hid_t memorySpaceHDF5 = H5Screate_simple(1, localLength, NULL);
+      const hid_t iterationSpaceHDF5 = H5Dget_space(iterationHDF5);
+      H5Sselect_hyperslab(iterationSpaceHDF5, H5S_SELECT_SET, localOffset, NULL,
+                          localLength, NULL);
+      if (MPIInit::rank[d::X] != 0) {
+        H5Sselect_none(memorySpaceHDF5);
+        H5Sselect_none(iterationSpaceHDF5);
+      }
+
+      const hid_t transferListHDF5 = H5Pcreate(H5P_DATASET_XFER);
+      H5Pset_dxpl_mpio(transferListHDF5, H5FD_MPIO_COLLECTIVE);
+      statusHDF5 = H5Dwrite(iterationHDF5, H5T_NATIVE_INT, memorySpaceHDF5,
+                            iterationSpaceHDF5, transferListHDF5, &value);
+
+      statusHDF5 = H5Pclose(transferListHDF5);
+      statusHDF5 = H5Sclose(iterationSpaceHDF5);
+      statusHDF5 = H5Sclose(memorySpaceHDF5);
+      statusHDF5 = H5Dclose(iterationHDF5);
+    }
+
+    /// Scalar attribute of the current dataset, written collectively
+    inline void writeAttribute(const std::string& name, const T value) {
+      const hid_t attributeSpaceHDF5 = H5Screate(H5S_SCALAR);
+      const hid_t attributeHDF5 =
+        H5Acreate2(dataSetHDF5, name.c_str(), H5T_NATIVE_DOUBLE,
+                   attributeSpaceHDF5, H5P_DEFAULT, H5P_DEFAULT);
+
+      statusHDF5 = H5Awrite(attributeHDF5, H5T_NATIVE_DOUBLE, &value);
+      statusHDF5 = H5Aclose(attributeHDF5);
+      statusHDF5 = H5Sclose(attributeSpaceHDF5);
+    }
+
+    inline void open(const std::string& fileName,
+                     const std::map<std::string, std::vector<int>>& attributes) {
       propertyListHDF5 = H5Pcreate(H5P_FILE_ACCESS);
-      H5Pset_fapl_mpio(propertyListHDF5, MPI_COMM_WORLD, MPI_INFO_NULL);
+      H5Pset_fapl_mpio(propertyListHDF5,
+                       outputPipelinePtr ? outputPipelinePtr->getCommunicator()
+                                         : MPI_COMM_WORLD,
+                       MPI_INFO_NULL);
 
       fileHDF5 = H5Fcreate(fileName.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT,
                            propertyListHDF5);
@@ -376,6 +896,18 @@ namespace lbm {
       if (!fileHDF5) {
         std::cout << "Could not open file " << fileName << std::endl;
       }
+
+      for (auto iA = attributes.begin(); iA != attributes.end(); ++iA) {
+        const hsize_t numberValues = iA->second.size();
+        const hid_t attributeSpaceHDF5 = H5Screate_simple(1, &numberValues, NULL);
+        const hid_t attributeHDF5 =
+          H5Acreate2(fileHDF5, iA->first.c_str(), H5T_NATIVE_INT,
+                     attributeSpaceHDF5, H5P_DEFAULT, H5P_DEFAULT);
+
+        statusHDF5 = H5Awrite(attributeHDF5, H5T_NATIVE_INT, iA->second.data());
+        statusHDF5 = H5Aclose(attributeHDF5);
+        statusHDF5 = H5Sclose(attributeSpaceHDF5);
+      }
     }
   };
 
@@ -390,62 +922,596 @@ namespace lbm {
 
   public:
     DistributionWriter(const std::string& filePrefix_in)
-      : Base(filePrefix_in, "distribution")
-    {}
+      : Base(filePrefix_in, "distribution", false, false)
+    {
+      const std::map<std::string, std::vector<int>> attributes =
+        getCheckpointAttributes();
+      for (auto iA = attributes.begin(); iA != attributes.end(); ++iA) {
+        Base::setFileAttribute(iA->first, iA->second);
+      }
+    }
+
+    /**
+     * Describes how the checkpoint was written. Populations are stored as
+     * global unpadded datasets, so only the global lengths and the lattice
+     * must match on restart; layout and decomposition are informative.
+     */
+    static inline std::map<std::string, std::vector<int>> getCheckpointAttributes() {
+      std::map<std::string, std::vector<int>> attributes;
+
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        attributes["global_length"].push_back(gSD::sLength()[iD]);
+      }
+      attributes["lattice"] = {(int)latticeT, L::dimD, L::dimQ};
+      attributes["memory_layout"] = {(int)memoryL};
+      attributes["decomposition"] = {(int)partitionningT, numProcs};
+
+      return attributes;
+    }
 
     inline bool getIsBackedUp(const unsigned int iteration) {
       return (iteration % backUpStep) == 0;
     }
 
+    /**
+     * Checkpoints hold the unpadded local block of each population. On CPU
+     * it is read in place from the halo distribution through a memory
+     * hyperslab that skips halo cells; on GPU each population is first
+     * staged in the distribution's host field.
+     */
     template <Architecture architecture>
-    void writeDistribution(Distribution<T, architecture>& distribution) {
-      LBM_INSTRUMENT_ON("Writer<HDF5>::writeField<NumberComponents>", 3)
+    void writeDistribution(Distribution<T, architecture>& distribution,
+                           const T* haloDistributionPtr,
+                           const Stream<architecture>& stream) {
+      LBM_INSTRUMENT_ON("Writer<HDF5>::writeDistribution", 3)
+
+      for (auto iQ = 0; iQ < L::dimQ; ++iQ) {
+        const std::string name = distribution.fieldName + std::to_string(iQ);
+
+        if (architecture == Architecture::CPU) {
+          writeSelection(name, haloDistributionPtr, getHaloSpace(iQ),
+                         [=](const Position& iP) {
+                           return hSD::getIndex(iP + L::halo(), iQ);
+                         });
+        }
+        else {
+          writeSelection(name,
+                         distribution.stagePopulation(stream, haloDistributionPtr, iQ),
+                         getPaddedSpace(), [=](const Position& iP) {
+                           return lSD::getIndex(iP);
+                         });
+        }
+      }
+    }
+
+    /// Population iQ of the halo distribution, components outermost in SoA
+    /// and innermost in AoS
+    static inline hid_t getHaloSpace(const unsigned int iQ) {
+      const unsigned int iComponentAxis =
+        memoryL == MemoryLayout::AoS ? L::dimD : 0;
+      const unsigned int iSpaceAxis = memoryL == MemoryLayout::AoS ? 0 : 1;
+
+      hsize_t haloLength[4];
+      hsize_t start[4];
+      hsize_t count[4];
+      haloLength[iComponentAxis] = L::dimQ;
+      start[iComponentAxis] = iQ;
+      count[iComponentAxis] = 1;
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        haloLength[iSpaceAxis + iD] = hSD::length()[iD];
+        start[iSpaceAxis + iD] = L::halo()[iD];
+        count[iSpaceAxis + iD] = lSD::sLength()[iD];
+      }
+
+      const hid_t memorySpace = H5Screate_simple(L::dimD + 1, haloLength, NULL);
+      H5Sselect_hyperslab(memorySpace, H5S_SELECT_SET, start, NULL, count, NULL);
+      return memorySpace;
+    }
+
+    /// Unpadded block of a field padded for in-place FFTs
+    static inline hid_t getPaddedSpace() {
+      const hid_t memorySpace = H5Screate_simple(
+        L::dimD, Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(),
+        NULL);
+      H5Sselect_hyperslab(
+        memorySpace, H5S_SELECT_SET,
+        Project<hsize_t, unsigned int, L::dimD>::Do(lSD::sStart()).data(), NULL,
+        Project<hsize_t, unsigned int, L::dimD>::Do(lSD::sLength()).data(), NULL);
+      return memorySpace;
+    }
+
+  private:
+    /// Writes in place, or gathers the selection into a staging buffer
+    template <class Index>
+    void writeSelection(const std::string& name, const T* dataPtr,
+                        const hid_t memorySpaceHDF5, Index getIndex) {
+      if (Base::outputPipelinePtr) {
+        std::vector<T>& buffer =
+          Base::outputPipelinePtr->getBuffer(Base::stagedBuffer);
+        typename Base::StagedDataset stagedDataset = {
+          name, L::dimQ, (unsigned int)buffer.size(), 0};
+
+        Position iP{{0}};
+        for (iP[d::X] = 0; iP[d::X] < lSD::sLength()[d::X]; ++iP[d::X]) {
+          for (iP[d::Y] = 0; iP[d::Y] < lSD::sLength()[d::Y]; ++iP[d::Y]) {
+            for (iP[d::Z] = 0; iP[d::Z] < lSD::sLength()[d::Z]; ++iP[d::Z]) {
+              buffer.push_back(dataPtr[getIndex(iP)]);
+            }
+          }
+        }
 
-        Base::propertyListHDF5 = H5Pcreate(H5P_DATASET_XFER);
-      for (auto iC = 0; iC < L::dimQ; ++iC) {
-        Base::fileSpaceHDF5 = H5Screate_simple(L::dimD,
-          Project<hsize_t, unsigned int, L::dimD>::Do(gSD::pLength()).data(),
-          NULL);
+        Base::stagedDatasets.push_back(stagedDataset);
+      }
+      else {
+        Base::writeDatasetNow(name, dataPtr, L::dimQ, 0, memorySpaceHDF5);
+      }
 
-        Base::dataSetHDF5 = H5Dcreate2(Base::fileHDF5,
-          (distribution.fieldName + std::to_string(iC)).c_str(),
-          H5T_NATIVE_DOUBLE, Base::fileSpaceHDF5, H5P_DEFAULT, H5P_DEFAULT,
-          H5P_DEFAULT);
+      H5Sclose(memorySpaceHDF5);
+    }
 
-        Base::statusHDF5 = H5Sclose(Base::fileSpaceHDF5);
+  public:
+    using Base::closeFile;
+    using Base::openFile;
+    using Base::setDatasetLayout;
+    using Base::setOutputPipeline;
+  };
 
-        Base::dataSpaceHDF5 = H5Screate_simple(L::dimD,
-          Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(),
-          NULL);
+  /// Compile-time comparison of names given in the inputs
+  constexpr bool getIsEqual(const char* name, const char* otherName) {
+    return *name == *otherName && (*name == '\0' || getIsEqual(name + 1, otherName + 1));
+  }
 
-        Base::fileSpaceHDF5 = H5Dget_space(Base::dataSetHDF5);
+  /// Whether one of the output subsets samples fieldName
+  constexpr bool getIsSubsetField(const char* fieldName, const unsigned int iS = 0) {
+    return iS < numberOutputSubsets
+      && (getIsEqual(outputSubsets[iS].fieldName, fieldName)
+          || getIsSubsetField(fieldName, iS + 1));
+  }
 
-        H5Sselect_hyperslab(Base::fileSpaceHDF5, H5S_SELECT_SET,
-          Project<hsize_t, unsigned int, L::dimD>::Do(gSD::pOffset(MPIInit::rank)).data(),
-          NULL, Project<hsize_t, unsigned int, L::dimD>::Do(lSD::pLength()).data(), NULL);
+  template <class T, InputOutput inputOutput>
+  class SubsetWriter {};
+
+  /**
+   * In-situ output of the subsets listed in outputSubsets. Each rank
+   * extracts the nodes or blocks starting in its part of the domain. A block
+   * may straddle ranks along X: the partial sums of such a plane of blocks
+   * are sent to the rank owning it before averaging. Subsets due
+   * at an iteration share one file, written collectively with one XDMF
+   * CoRectMesh grid per subset. With an output pipeline, extracted values
+   * are staged and the file is written by the I/O thread.
+   */
+  template <class T>
+  class SubsetWriter<T, InputOutput::HDF5>
+    : public Writer<T, InputOutput::Generic, InputOutputFormat::Generic> {
+  private:
+    using Base = Writer<T, InputOutput::Generic, InputOutputFormat::Generic>;
 
-        H5Pset_dxpl_mpio(Base::propertyListHDF5, H5FD_MPIO_COLLECTIVE);
+    /// Coarse grid of a subset and the part of it owned by this rank
+    struct SubsetLayout {
+      OutputSubset subset;
+      Position start;
+      Position end;
+      Position step;
+      Position length;
+      Position localBegin;
+      Position localLength;
+      int partialPlane;
+      std::vector<int> partialSources;
+    };
+
+    /// Extracted values of subset iS, staged from begin in the buffer
+    struct StagedSubset {
+      unsigned int iS;
+      std::string name;
+      unsigned int begin;
+    };
 
-        Base::statusHDF5 =
-          H5Dwrite(Base::dataSetHDF5, H5T_NATIVE_DOUBLE, Base::dataSpaceHDF5,
-                   Base::fileSpaceHDF5, Base::propertyListHDF5,
-                   distribution.getData(FFTWInit::numberElements, iC));
+    hid_t fileHDF5;
+    herr_t statusHDF5;
+    std::vector<SubsetLayout> subsetLayouts;
+    std::vector<std::vector<std::string>> datasetNames;
+    std::vector<T> subsetArray;
+    std::vector<T> sumArray;
+    std::vector<T> partialArray;
+    std::vector<T> receivedArray;
+    unsigned int fileIteration;
+    Computation<Architecture::CPU, L::dimD> computationLocal;
+
+    OutputPipeline<T>* outputPipelinePtr;
+    unsigned int stagedBuffer;
+    std::vector<StagedSubset> stagedSubsets;
 
-        Base::statusHDF5 = H5Dclose(Base::dataSetHDF5);
-        Base::statusHDF5 = H5Sclose(Base::dataSpaceHDF5);
-        Base::statusHDF5 = H5Sclose(Base::fileSpaceHDF5);
+  public:
+    SubsetWriter(const std::string& filePrefix_in)
+      : Base(filePrefix_in + "/", "subsets", ".h5", "binary")
+      , datasetNames(numberOutputSubsets)
+      , fileIteration(0)
+      , computationLocal(lSD::sStart(), lSD::sEnd())
+      , outputPipelinePtr(NULL)
+      , stagedBuffer(0)
+    {
+      for (auto iS = 0; iS < numberOutputSubsets; ++iS) {
+        subsetLayouts.push_back(getSubsetLayout(outputSubsets[iS]));
+      }
+    }
 
-        if (MPIInit::rank[d::X] == 0) {
-          Base::writerXDMF.write(distribution.fieldName + std::to_string(iC),
-                                 L::dimQ);
+    inline bool getIsWritten(const unsigned int iteration) {
+      bool isWritten = false;
+      for (auto iS = 0; iS < subsetLayouts.size(); ++iS) {
+        isWritten = isWritten || getIsWritten(iteration, iS);
+      }
+      return isWritten;
+    }
+
+    inline bool getIsWritten(const unsigned int iteration,
+                             const std::string& fieldName) {
+      bool isWritten = false;
+      for (auto iS = 0; iS < subsetLayouts.size(); ++iS) {
+        isWritten = isWritten || (getIsWritten(iteration, iS)
+                                  && fieldName == subsetLayouts[iS].subset.fieldName);
+      }
+      return isWritten;
+    }
+
+    /// Files are then only staged here and written by the pipeline
+    inline void setOutputPipeline(OutputPipeline<T>* outputPipelinePtr_in) {
+      outputPipelinePtr = outputPipelinePtr_in;
+    }
+
+    inline void openFile(const unsigned int iteration) {
+      fileIteration = iteration;
+      for (auto iS = 0; iS < datasetNames.size(); ++iS) {
+        datasetNames[iS].clear();
+      }
+
+      if (outputPipelinePtr) {
+        stagedBuffer = outputPipelinePtr->acquireBuffer();
+        outputPipelinePtr->getBuffer(stagedBuffer).clear();
+        stagedSubsets.clear();
+      }
+      else {
+        openFileNow(iteration);
+      }
+    }
+
+    inline void closeFile() {
+      if (outputPipelinePtr) {
+        const unsigned int iteration = fileIteration;
+        const unsigned int iB = stagedBuffer;
+        const std::vector<StagedSubset> subsets = stagedSubsets;
+        const std::vector<std::vector<std::string>> names = datasetNames;
+
+        outputPipelinePtr->submit(iB, [=] {
+            const T* bufferPtr = outputPipelinePtr->getBuffer(iB).data();
+
+            openFileNow(iteration);
+            for (auto iS = 0; iS < subsets.size(); ++iS) {
+              writeDatasetNow(subsetLayouts[subsets[iS].iS], subsets[iS].name,
+                              bufferPtr + subsets[iS].begin);
+            }
+            closeFileNow(iteration, names);
+          });
+      }
+      else {
+        closeFileNow(fileIteration, datasetNames);
+      }
+    }
+
+    /// Writes every component of field for each due subset selecting it
+    template <unsigned int NumberComponents, Architecture architecture,
+              bool IsTransformed>
+    void writeField(Field<T, NumberComponents, architecture, true, IsTransformed>& field) {
+      LBM_INSTRUMENT_ON("Writer<HDF5>::writeSubset<NumberComponents>", 3)
+
+      for (auto iS = 0; iS < subsetLayouts.size(); ++iS) {
+        const SubsetLayout& layout = subsetLayouts[iS];
+        if (!getIsWritten(fileIteration, iS)
+            || field.fieldName != layout.subset.fieldName) continue;
+
+        for (auto iC = 0; iC < NumberComponents; ++iC) {
+          std::string name = std::string(layout.subset.name) + "_" + field.fieldName;
+          if (NumberComponents > 1) {
+            name += dName[iC];
+          }
+
+          extract(layout, field.getData(field.getNumberElements(), iC));
+          datasetNames[iS].push_back(name);
+
+          if (outputPipelinePtr) {
+            std::vector<T>& buffer = outputPipelinePtr->getBuffer(stagedBuffer);
+            StagedSubset stagedSubset = {(unsigned int)iS, name,
+                                         (unsigned int)buffer.size()};
+            buffer.insert(buffer.end(), subsetArray.begin(), subsetArray.end());
+            stagedSubsets.push_back(stagedSubset);
+          }
+          else {
+            writeDatasetNow(layout, name, subsetArray.data());
+          }
         }
       }
+    }
 
-      Base::statusHDF5 = H5Pclose(Base::propertyListHDF5);
+    template <unsigned int NumberComponents, Architecture architecture,
+              bool IsTransformed>
+    void writeField(Field<T, NumberComponents, architecture, false, IsTransformed>& field) {}
+
+  private:
+    inline bool getIsWritten(const unsigned int iteration, const unsigned int iS) {
+      return (iteration % subsetLayouts[iS].subset.writeStep) == 0;
     }
 
-    using Base::closeFile;
-    using Base::openFile;
+    static inline unsigned int getVolume(const Position& length) {
+      return length[d::X] * length[d::Y] * length[d::Z];
+    }
+
+    static inline unsigned int getIndex(const Position& iP, const Position& length) {
+      return length[d::Z] * (length[d::Y] * iP[d::X] + iP[d::Y]) + iP[d::Z];
+    }
+
+    /// Coarse index k is owned by the rank holding node start + k * step
+    static inline SubsetLayout getSubsetLayout(const OutputSubset& subset) {
+      const Position offset = gSD::sOffset(MPIInit::rank);
+      SubsetLayout layout = {subset, {{0, 0, 0}}, {{1, 1, 1}}, {{1, 1, 1}},
+                             {{1, 1, 1}}, {{0, 0, 0}}, {{1, 1, 1}}, -1, {}};
+
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        const unsigned int start = subset.start[iD];
+        const unsigned int end = subset.end[iD] ? subset.end[iD] : gSD::sLength()[iD];
+        const unsigned int step = subset.step[iD] ? subset.step[iD] : 1;
+        const unsigned int length = end > start ? (end - start + step - 1) / step : 0;
+        const unsigned int localEnd = offset[iD] + lSD::sLength()[iD];
+
+        layout.start[iD] = start;
+        layout.end[iD] = end;
+        layout.step[iD] = step;
+        layout.length[iD] = length;
+        layout.localBegin[iD] = offset[iD] > start
+          ? std::min((offset[iD] - start + step - 1) / step, length) : 0;
+        layout.localLength[iD] = (localEnd > start
+          ? std::min((localEnd - start + step - 1) / step, length) : 0)
+          - layout.localBegin[iD];
+      }
+
+      if (subset.subsetT == SubsetType::Average) {
+        layout.partialPlane = getPartialPlane(layout, MPIInit::rank[d::X]);
+        for (auto iR = 0; iR < numProcs; ++iR) {
+          const int partialPlane = getPartialPlane(layout, iR);
+          if (iR != MPIInit::rank[d::X] && partialPlane >= 0
+              && getOwner(layout, partialPlane) == MPIInit::rank[d::X]) {
+            layout.partialSources.push_back(iR);
+          }
+        }
+      }
+
+      return layout;
+    }
+
+    /// Plane of blocks touched by rank iR but starting on a rank to its left
+    static inline int getPartialPlane(const SubsetLayout& layout, const int iR) {
+      const unsigned int offsetX = lSD::sLength()[d::X] * iR;
+      if (offsetX <= layout.start[d::X] || offsetX >= layout.end[d::X]
+          || (offsetX - layout.start[d::X]) % layout.step[d::X] == 0) return -1;
+
+      return (offsetX - layout.start[d::X]) / layout.step[d::X];
+    }
+
+    static inline int getOwner(const SubsetLayout& layout, const unsigned int iKX) {
+      return (layout.start[d::X] + iKX * layout.step[d::X]) / lSD::sLength()[d::X];
+    }
+
+    /// Adds the partial sums of the owned planes computed by other ranks
+    inline void exchangePartialSums(const SubsetLayout& layout) {
+      const unsigned int planeVolume = layout.length[d::Y] * layout.length[d::Z];
+      std::vector<MPI_Request> requests(layout.partialSources.size()
+                                        + (layout.partialPlane >= 0));
+      receivedArray.resize(layout.partialSources.size() * planeVolume);
+
+      for (auto iR = 0; iR < layout.partialSources.size(); ++iR) {
+        MPI_Irecv(receivedArray.data() + iR * planeVolume, planeVolume, MPI_DOUBLE,
+                  layout.partialSources[iR], 50, MPI_COMM_WORLD, &requests[iR]);
+      }
+      if (layout.partialPlane >= 0) {
+        MPI_Isend(partialArray.data(), planeVolume, MPI_DOUBLE,
+                  getOwner(layout, layout.partialPlane), 50, MPI_COMM_WORLD,
+                  &requests.back());
+      }
+      MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+
+      for (auto iR = 0; iR < layout.partialSources.size(); ++iR) {
+        const unsigned int localPlane =
+          getPartialPlane(layout, layout.partialSources[iR]) - layout.localBegin[d::X];
+        for (auto iYZ = 0; iYZ < planeVolume; ++iYZ) {
+          sumArray[localPlane * planeVolume + iYZ] +=
+            receivedArray[iR * planeVolume + iYZ];
+        }
+      }
+    }
+
+    /// Fills subsetArray with the coarse values owned by this rank
+    inline void extract(const SubsetLayout& layout, const T* dataPtr) {
+      const Position offset = gSD::sOffset(MPIInit::rank);
+      subsetArray.assign(std::max(getVolume(layout.localLength), 1u), 0);
+
+      if (layout.subset.subsetT == SubsetType::Average) {
+        const unsigned int planeVolume = layout.length[d::Y] * layout.length[d::Z];
+        sumArray.assign(std::max(getVolume(layout.localLength), 1u), 0);
+        partialArray.assign(planeVolume, 0);
+
+        computationLocal.Do([&] LBM_HOST(const Position& iP) {
+            Position iK{{0, 0, 0}};
+            for (auto iD = 0; iD < L::dimD; ++iD) {
+              const unsigned int iG = iP[iD] + offset[iD];
+              if (iG < layout.start[iD] || iG >= layout.end[iD]) return;
+              iK[iD] = (iG - layout.start[iD]) / layout.step[iD];
+            }
+
+            if ((int)iK[d::X] == layout.partialPlane) {
+              partialArray[iK[d::Y] * layout.length[d::Z] + iK[d::Z]]
+                += dataPtr[lSD::getIndex(iP)];
+            }
+            else {
+              iK[d::X] -= layout.localBegin[d::X];
+              sumArray[getIndex(iK, layout.localLength)] += dataPtr[lSD::getIndex(iP)];
+            }
+          });
+        computationLocal.synchronize();
+
+        exchangePartialSums(layout);
+      }
+
+      Position iK;
+      for (iK[d::X] = 0; iK[d::X] < layout.localLength[d::X]; ++iK[d::X]) {
+        for (iK[d::Y] = 0; iK[d::Y] < layout.localLength[d::Y]; ++iK[d::Y]) {
+          for (iK[d::Z] = 0; iK[d::Z] < layout.localLength[d::Z]; ++iK[d::Z]) {
+            const Position iK_global = iK + layout.localBegin;
+
+            if (layout.subset.subsetT == SubsetType::Average) {
+              unsigned int numberNodes = 1;
+              for (auto iD = 0; iD < L::dimD; ++iD) {
+                numberNodes *= std::min(layout.step[iD], layout.end[iD]
+                                        - layout.start[iD] - iK_global[iD] * layout.step[iD]);
+              }
+              subsetArray[getIndex(iK, layout.localLength)] =
+                sumArray[getIndex(iK, layout.localLength)] / numberNodes;
+            }
+            else {
+              Position iP{{0, 0, 0}};
+              for (auto iD = 0; iD < L::dimD; ++iD) {
+                iP[iD] = layout.start[iD] + iK_global[iD] * layout.step[iD] - offset[iD];
+              }
+              subsetArray[getIndex(iK, layout.localLength)] = dataPtr[lSD::getIndex(iP)];
+            }
+          }
+        }
+      }
+    }
+
+    /// Communicator reserved to the I/O thread when writing from the pipeline
+    inline void openFileNow(const unsigned int iteration) {
+      const hid_t propertyListHDF5 = H5Pcreate(H5P_FILE_ACCESS);
+      H5Pset_fapl_mpio(propertyListHDF5,
+                       outputPipelinePtr ? outputPipelinePtr->getCommunicator()
+                                         : MPI_COMM_WORLD,
+                       MPI_INFO_NULL);
+      fileHDF5 = H5Fcreate(Base::getFileName(iteration).c_str(), H5F_ACC_TRUNC,
+                           H5P_DEFAULT, propertyListHDF5);
+      H5Pclose(propertyListHDF5);
+
+      if (!fileHDF5) {
+        std::cout << "Could not open file " << Base::getFileName(iteration)
+                  << std::endl;
+      }
+    }
+
+    inline void closeFileNow(const unsigned int iteration,
+                             const std::vector<std::vector<std::string>>& names) {
+      statusHDF5 = H5Fclose(fileHDF5);
+
+      if (MPIInit::rank[d::X] == 0) {
+        writeXDMF(iteration, names);
+      }
+    }
+
+    inline void writeDatasetNow(const SubsetLayout& layout, const std::string& name,
+                                const T* dataPtr) {
+      const hid_t fileSpaceHDF5 = H5Screate_simple(
+        L::dimD, Project<hsize_t, unsigned int, L::dimD>::Do(layout.length).data(),
+        NULL);
+      const hid_t dataSetHDF5 =
+        H5Dcreate2(fileHDF5, name.c_str(), H5T_NATIVE_DOUBLE, fileSpaceHDF5,
+                   H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+      const hid_t dataSpaceHDF5 = H5Screate_simple(
+        L::dimD, Project<hsize_t, unsigned int, L::dimD>::Do(layout.localLength).data(),
+        NULL);
+
+      if (getVolume(layout.localLength) == 0) {
+        H5Sselect_none(fileSpaceHDF5);
+        H5Sselect_none(dataSpaceHDF5);
+      }
+      else {
+        H5Sselect_hyperslab(
+          fileSpaceHDF5, H5S_SELECT_SET,
+          Project<hsize_t, unsigned int, L::dimD>::Do(layout.localBegin).data(), NULL,
+          Project<hsize_t, unsigned int, L::dimD>::Do(layout.localLength).data(), NULL);
+      }
+
+      const hid_t propertyListHDF5 = H5Pcreate(H5P_DATASET_XFER);
+      H5Pset_dxpl_mpio(propertyListHDF5, H5FD_MPIO_COLLECTIVE);
+      statusHDF5 = H5Dwrite(dataSetHDF5, H5T_NATIVE_DOUBLE, dataSpaceHDF5,
+                            fileSpaceHDF5, propertyListHDF5, dataPtr);
+
+      statusHDF5 = H5Pclose(propertyListHDF5);
+      statusHDF5 = H5Sclose(dataSpaceHDF5);
+      statusHDF5 = H5Dclose(dataSetHDF5);
+      statusHDF5 = H5Sclose(fileSpaceHDF5);
+    }
+
+    /// Block averages are located at the block centers
+    inline void writeXDMF(const unsigned int iteration,
+                          const std::vector<std::vector<std::string>>& names) {
+      std::ostringstream number;
+      number << iteration;
+      const std::string fileNameHDF5 = Base::filePrefix + "-" + number.str() + ".h5";
+
+      Base::file.open(Base::writeFolder + Base::writerFolder + Base::filePrefix
+                      + "-" + number.str() + ".xmf",
+                      std::ofstream::out | std::ofstream::trunc);
+      Base::file << "<?xml version=\"1.0\"?>\n"
+                 << "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n"
+                 << "<Xdmf>\n"
+                 << "<Domain>\n";
+
+      for (auto iS = 0; iS < subsetLayouts.size(); ++iS) {
+        if (names[iS].empty()) continue;
+        const SubsetLayout& layout = subsetLayouts[iS];
+        const bool isAverage = layout.subset.subsetT == SubsetType::Average;
+
+        Base::file << "<Grid Name=\"" << layout.subset.name
+                   << "\" GridType=\"Uniform\">\n"
+                   << "<Topology TopologyType=\"" << L::dimD
+                   << "DCoRectMesh\" Dimensions=\"";
+        writeVector(layout.length);
+        Base::file << "\" />\n"
+                   << "<Geometry GeometryType=\"Origin_Dx"
+                   << (L::dimD >= 2 ? "Dy" : "") << (L::dimD == 3 ? "Dz" : "")
+                   << "\">\n"
+                   << "<DataItem Dimensions=\"" << L::dimD
+                   << "\" NumberType=\"Float\" Format=\"XML\">";
+        for (auto iD = 0; iD < L::dimD; ++iD) {
+          Base::file << (iD ? " " : "") << layout.start[iD]
+            + (isAverage ? (layout.step[iD] - 1) / 2.0 : 0.0);
+        }
+        Base::file << "</DataItem>\n"
+                   << "<DataItem Dimensions=\"" << L::dimD
+                   << "\" NumberType=\"Integer\" Format=\"XML\">";
+        writeVector(layout.step);
+        Base::file << "</DataItem>\n"
+                   << "</Geometry>\n";
+
+        for (auto iN = 0; iN < names[iS].size(); ++iN) {
+          Base::file << "<Attribute Name=\"" << names[iS][iN] << "\" "
+                     << "AttributeType=\"Scalar\" Center=\"Node\">\n"
+                     << "<DataItem Dimensions=\"";
+          writeVector(layout.length);
+          Base::file << "\" NumberType=\"Double\" Precision=\"8\" Format=\"HDF\">\n"
+                     << fileNameHDF5 << ":/" << names[iS][iN] << "\n"
+                     << "</DataItem>\n"
+                     << "</Attribute>\n";
+        }
+
+        Base::file << "</Grid>\n";
+      }
+
+      Base::file << "</Domain>\n"
+                 << "</Xdmf>\n";
+      Base::file.close();
+    }
+
+    inline void writeVector(const Position& vector) {
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        Base::file << (iD ? " " : "") << vector[iD];
+      }
+    }
   };
 
   template <class T>
@@ -455,20 +1521,38 @@ namespace lbm {
     using Base = Writer<T, InputOutput::Generic, InputOutputFormat::ascii>;
 
   public:
-    FieldWriter(const std::string& filePrefix_in, const std::string& name_in)
+    FieldWriter(const std::string& filePrefix_in, const std::string& name_in,
+                const bool isTimeSeries_in = false,
+                const std::string& seriesPostfix_in = "")
       : Base(filePrefix_in + "/", name_in, ".xmf")
       , fileName("/dev/null")
       , fileNameHDF5("/dev/null")
+      , isTimeSeries(isTimeSeries_in)
+      , seriesPostfix(seriesPostfix_in)
     {}
 
     inline void openFile(const unsigned int iteration) {
+      if (isTimeSeries) {
+        seriesIterations.push_back(iteration);
+        seriesNames.push_back(std::vector<std::string>());
+        return;
+      }
+
       fileName = Base::getFileName(iteration);
       fileNameHDF5 = getFileNameHDF5(iteration);
       Base::openAndTruncate(fileName);
       writeHeader();
+      writeGridHeader(iteration);
     }
 
+    /// A time series is rewritten whole, so the file is valid after each snapshot
     inline void closeFile() {
+      if (isTimeSeries) {
+        writeSeries();
+        return;
+      }
+
+      Base::file << "</Grid>\n";
       writeFooter();
       Base::file.close();
     }
@@ -476,14 +1560,17 @@ namespace lbm {
     void write(const std::string& name, unsigned int numberComponents) {
       LBM_INSTRUMENT_ON("Writer<XDMF>::writeField<NumberComponents>",3)
 
-        Base::file
+      if (isTimeSeries) {
+        seriesNames.back().push_back(name);
+        seriesExtents[name] = seriesIterations.size();
+        return;
+      }
+
+      Base::file
         << "<Attribute Name=\"" << name << "\" "
         << "AttributeType=\"Scalar\" Center=\"Node\">\n";
-      Base::file << "<DataItem Dimensions=\"" << gSD::pLength()[d::X];
-
-      for (auto iD = 1; iD < L::dimD; ++iD) {
-        Base::file << " " << gSD::sLength()[iD];
-      }
+      Base::file << "<DataItem Dimensions=\"";
+      writeDimensions();
       Base::file << "\" ";
       Base::file << "NumberType=\"Double\" Precision=\"8\" Format=\"HDF\">\n";
       Base::file << fileNameHDF5 << ":/" << name << "\n";
@@ -495,6 +1582,12 @@ namespace lbm {
     std::string fileName;
     std::string fileNameHDF5;
 
+    const bool isTimeSeries;
+    const std::string seriesPostfix;
+    std::vector<unsigned int> seriesIterations;
+    std::vector<std::vector<std::string>> seriesNames;
+    std::map<std::string, unsigned int> seriesExtents;
+
     std::string getFileNameHDF5(const unsigned int iteration) {
       std::ostringstream number;
 
@@ -504,20 +1597,80 @@ namespace lbm {
       return fileNameR;
     }
 
+    void writeDimensions() {
+      Base::file << gSD::pLength()[d::X];
+
+      for (auto iD = 1; iD < L::dimD; ++iD) {
+        Base::file << " " << gSD::sLength()[iD];
+      }
+    }
+
+    /// Temporal collection of snapshots selected from the extendible datasets
+    void writeSeries() {
+      LBM_INSTRUMENT_ON("Writer<XDMF>::writeSeries",2)
+
+      Base::openAndTruncate(Base::getFileName(seriesPostfix));
+      writeHeader();
+      Base::file << "<Grid Name=\"series\" GridType=\"Collection\" "
+                 << "CollectionType=\"Temporal\">\n";
+
+      for (auto iS = 0; iS < seriesIterations.size(); ++iS) {
+        writeGridHeader(seriesIterations[iS]);
+        Base::file << "<Time Value=\"" << seriesIterations[iS] << "\" />\n";
+
+        for (auto iN = 0; iN < seriesNames[iS].size(); ++iN) {
+          const std::string& name = seriesNames[iS][iN];
+
+          Base::file
+            << "<Attribute Name=\"" << name << "\" "
+            << "AttributeType=\"Scalar\" Center=\"Node\">\n";
+          Base::file << "<DataItem ItemType=\"HyperSlab\" Dimensions=\"";
+          writeDimensions();
+          Base::file << "\" Type=\"HyperSlab\">\n";
+
+          Base::file << "<DataItem Dimensions=\"3 " << L::dimD + 1
+                     << "\" Format=\"XML\">" << iS;
+          for (auto iD = 0; iD < L::dimD; ++iD) Base::file << " 0";
+          for (auto iD = 0; iD <= L::dimD; ++iD) Base::file << " 1";
+          Base::file << " 1 ";
+          writeDimensions();
+          Base::file << "</DataItem>\n";
+
+          Base::file << "<DataItem Dimensions=\"" << seriesExtents[name] << " ";
+          writeDimensions();
+          Base::file << "\" NumberType=\"Double\" Precision=\"8\" Format=\"HDF\">\n";
+          Base::file << Base::filePrefix << seriesPostfix << ".h5:/" << name << "\n";
+          Base::file << "</DataItem>\n";
+          Base::file << "</DataItem>\n";
+          Base::file << "</Attribute>\n";
+        }
+
+        Base::file << "</Grid>\n";
+      }
+
+      Base::file << "</Grid>\n";
+      writeFooter();
+      Base::file.close();
+    }
+
     void writeHeader() {
       LBM_INSTRUMENT_ON("Writer<XDMF>::writeHeader",2)
 
-        Base::file << "<?xml version=\"1.0\"?>\n";
+      Base::file << "<?xml version=\"1.0\"?>\n";
       Base::file << "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n";
       Base::file << "<Xdmf>\n";
       Base::file << "<Domain>\n";
-      Base::file << "<Grid Name=\"grid\" GridType=\"Uniform\">\n";
-      Base::file << "<Topology TopologyType=\"" << L::dimD
-                 << "DCoRectMesh\" Dimensions=\"" << gSD::pLength()[d::X];
+    }
 
-      for (auto iD = 1; iD < L::dimD; ++iD) {
-        Base::file << " " << gSD::sLength()[iD];
+    void writeGridHeader(const unsigned int iteration) {
+      Base::file << "<Grid Name=\"grid";
+      if (isTimeSeries) {
+        Base::file << "-" << iteration;
       }
+      Base::file << "\" GridType=\"Uniform\">\n";
+      Base::file << "<Topology TopologyType=\"" << L::dimD
+                 << "DCoRectMesh\" Dimensions=\"";
+      writeDimensions();
       Base::file << "\" />\n"
                  << "<Geometry GeometryType=\"Origin_Dx";
       if (L::dimD >= 2) {
@@ -550,8 +1703,7 @@ namespace lbm {
     void writeFooter() {
       LBM_INSTRUMENT_ON("Writer<XDMF>::writeFooter", 2)
 
-        Base::file
-        << "</Grid>\n"
+      Base::file
         << "</Domain>\n"
         << "</Xdmf>\n";
     }
@@ -559,9 +1711,10 @@ namespace lbm {
 
   typedef FieldWriter<dataT, InputOutput::HDF5> FieldWriter_;
   typedef DistributionWriter<dataT, InputOutput::HDF5> DistributionWriter_;
-  typedef ScalarAnalysisWriter<dataT, InputOutputFormat::ascii>
+  typedef SubsetWriter<dataT, InputOutput::HDF5> SubsetWriter_;
+  typedef ScalarAnalysisWriter<dataT, inputOutputFormatT>
     ScalarAnalysisWriter_;
-  typedef SpectralAnalysisWriter<dataT, InputOutputFormat::ascii>
+  typedef SpectralAnalysisWriter<dataT, inputOutputFormatT>
     SpectralAnalysisWriter_;
 
 }  // namespace lbm
@@ -0,0 +1,83 @@
+#include "Input.in"
+#include "metaLBM/Commons.h"
+#include "metaLBM/MPIInitializer.h"
+#include "metaLBM/FFTWInitializer.h"
+#include "metaLBM/MathVector.h"
+#include "metaLBM/ShellSum.h"
+#include "metaLBM/Writer.h"
+
+#include <sys/stat.h>
+#include <cmath>
+#include <random>
+
+/**
+ * Write throughput and compression ratio of the HDF5 field output for
+ * several dataset layouts. The written field is a synthetic turbulent
+ * velocity: random-phase modes in the shells [1, kMax] with a k^-5/3
+ * energy spectrum, synthesized in physical space. Throughput and ratio are
+ * relative to the unpadded field. With kMax = 8 the field is much smoother
+ * than resolved turbulence, so the compression ratios are optimistic.
+ */
+int main(int argc, char* argv[]) {
+  using namespace lbm;
+
+  auto mpiLauncher = MPIInitializer<numProcs>{argc, argv};
+  auto fftwLauncher = FFTWInitializer<numThreads>{};
+
+  constexpr unsigned int kMax = 8;
+  constexpr unsigned int numberRepetitions = 4;
+
+  Field<dataT, L::dimD, Architecture::CPU, true> velocity("velocity");
+  ShellSum<L::dimD> shellSum(1, kMax, gSD::sOffset(MPIInit::rank));
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> phaseDistribution(0, 2 * M_PI);
+  for (auto iM = 0; iM < shellSum.size(); ++iM) {
+    const double amplitude = gSD::sVolume() *
+      std::pow(shellSum.getWaveNumber(iM).norm2(), -(5.0 / 3 + L::dimD - 1) / 4);
+    for (auto iC = 0; iC < L::dimD; ++iC) {
+      const double phase = phaseDistribution(generator);
+      shellSum.setCoefficient(iM, iC, amplitude * cos(phase),
+                              amplitude * sin(phase));
+    }
+  }
+  shellSum.execute(velocity.getData(velocity.getNumberElements()),
+                   velocity.getNumberElements());
+
+  const std::string layoutNames[] = {"contiguous", "chunked", "deflate",
+                                     "shuffle+deflate", "shuffle+deflate-4"};
+  const DatasetLayout datasetLayouts[] = {
+    DatasetLayout(0, CompressionType::None),
+    DatasetLayout(1, CompressionType::None),
+    DatasetLayout(1, CompressionType::Deflate, 1),
+    DatasetLayout(1, CompressionType::ShuffleDeflate, 1),
+    DatasetLayout(1, CompressionType::ShuffleDeflate, 4)};
+  const double rawSize = (double)sizeof(dataT) * L::dimD * gSD::sVolume();
+
+  if (MPIInit::rank[d::X] == 0) {
+    std::cout << "layout throughput_MB/s ratio\n";
+  }
+
+  FieldWriter_ fieldWriter(prefix, "benchmark_io", false);
+  for (auto iL = 0; iL < 5; ++iL) {
+    fieldWriter.setDatasetLayout("", datasetLayouts[iL]);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double startTime = MPI_Wtime();
+    for (auto iR = 0; iR < numberRepetitions; ++iR) {
+      fieldWriter.openFile(iR);
+      fieldWriter.writeField(velocity);
+      fieldWriter.closeFile();
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double writeTime = (MPI_Wtime() - startTime) / numberRepetitions;
+
+    if (MPIInit::rank[d::X] == 0) {
+      struct stat fileStatus;
+      stat(fieldWriter.getFileName(0).c_str(), &fileStatus);
+
+      std::cout << layoutNames[iL] << " " << rawSize / writeTime / 1.e6 << " "
+                << rawSize / fileStatus.st_size << std::endl;
+    }
+  }
+}
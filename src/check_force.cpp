@@ -0,0 +1,64 @@
+#include "Input.in"
+#include "metaLBM/Commons.h"
+#include "metaLBM/MPIInitializer.h"
+#include "metaLBM/FFTWInitializer.h"
+#include "metaLBM/MathVector.h"
+#include "metaLBM/DynamicArray.h"
+#include "metaLBM/Force.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Checks that the constant shell force synthesized by the direct sum
+ * matches the one obtained through MakeIncompressible and backward FFTs.
+ * Prints the maximum difference relative to the maximum force and fails
+ * when it exceeds a round-off tolerance.
+ */
+int main(int argc, char* argv[]) {
+  using namespace lbm;
+
+  auto mpiLauncher = MPIInitializer<numProcs>{argc, argv};
+  auto fftwLauncher = FFTWInitializer<numThreads>{};
+
+  constexpr double tolerance = 1.e-10;
+
+  DynamicArray<double, Architecture::CPU>
+    directArray(L::dimD * FFTWInit::numberElements);
+  DynamicArray<double, Architecture::CPU>
+    fourierArray(L::dimD * FFTWInit::numberElements);
+
+  Force<double, ForceType::ConstantShell, Architecture::CPU>
+    directForce(gSD::sOffset(MPIInit::rank), forceAmplitude, forceWaveLength,
+                forcekMin, forcekMax, true);
+  Force<double, ForceType::ConstantShell, Architecture::CPU>
+    fourierForce(gSD::sOffset(MPIInit::rank), forceAmplitude, forceWaveLength,
+                 forcekMin, forcekMax, false);
+
+  directForce.setForceArray(directArray.data());
+  fourierForce.setForceArray(fourierArray.data());
+
+  double errorList[2] = {0.0, 0.0};
+  Computation<Architecture::CPU, L::dimD> computationLocal(lSD::sStart(),
+                                                           lSD::sEnd());
+  computationLocal.Do([&] LBM_HOST(const Position& iP) {
+      const auto index = lSD::getIndex(iP);
+      for (auto iD = 0; iD < L::dimD; ++iD) {
+        const double direct = directArray[iD * FFTWInit::numberElements + index];
+        const double fourier = fourierArray[iD * FFTWInit::numberElements + index];
+        errorList[0] = std::max(errorList[0], std::fabs(direct - fourier));
+        errorList[1] = std::max(errorList[1], std::fabs(fourier));
+      }
+  });
+  computationLocal.synchronize();
+
+  MPI_Allreduce(MPI_IN_PLACE, errorList, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  const double relativeError = errorList[0] / errorList[1];
+
+  if (MPIInit::rank[d::X] == 0) {
+    std::cout << "shells [" << forcekMin << ", " << forcekMax << "] "
+              << "max_relative_difference " << relativeError << std::endl;
+  }
+
+  return relativeError < tolerance ? 0 : 1;
+}